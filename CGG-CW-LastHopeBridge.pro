@@ -18,10 +18,28 @@ QMAKE_CXXFLAGS += -Wall -Wextra
 
 SOURCES += \
     aboutdialog.cpp \
+    core/aabbtree.cpp \
+    core/assetloader.cpp \
+    core/bakedmesh.cpp \
+    core/bakedtexture.cpp \
+    core/blockcompression.cpp \
+    core/frustum.cpp \
+    core/geometryarena.cpp \
+    core/glstate.cpp \
+    core/instancestream.cpp \
+    core/mappedfile.cpp \
     core/mesh.cpp \
+    core/meshoptimizer.cpp \
+    core/meshsimplifier.cpp \
+    core/modelcache.cpp \
     core/objloader.cpp \
+    core/programcache.cpp \
     core/shader.cpp \
+    core/shadervariants.cpp \
     core/texture.cpp \
+    core/textureregistry.cpp \
+    core/trianglebvh.cpp \
+    core/uniformbuffer.cpp \
     glwidget.cpp \
     main.cpp \
     mainwindow.cpp \
@@ -29,23 +47,46 @@ SOURCES += \
     scene/bridge.cpp \
     scene/camera.cpp \
     scene/object.cpp \
+    scene/renderqueue.cpp \
     scene/scene.cpp \
     scene/vehicle.cpp
 
 HEADERS += \
     aboutdialog.h \
     core/math3d.h \
+    core/aabbtree.h \
+    core/assetloader.h \
+    core/bakedmesh.h \
+    core/bakedtexture.h \
+    core/blockcompression.h \
+    core/bounds.h \
+    core/frustum.h \
+    core/geometryarena.h \
+    core/glstate.h \
+    core/instancestream.h \
+    core/mappedfile.h \
     core/mesh.h \
+    core/meshoptimizer.h \
+    core/meshsimplifier.h \
+    core/modelcache.h \
     core/objloader.h \
+    core/programcache.h \
     core/shader.h \
+    core/shadervariants.h \
     core/texture.h \
+    core/textureregistry.h \
+    core/trianglebvh.h \
+    core/uniformbuffer.h \
+    core/vertexmap.h \
     glwidget.h \
     mainwindow.h \
     scene/boat.h \
     scene/bridge.h \
     scene/camera.h \
     scene/object.h \
+    scene/renderqueue.h \
     scene/scene.h \
+    scene/uniforms.h \
     scene/vehicle.h
 
 # Default rules for deployment.
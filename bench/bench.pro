@@ -0,0 +1,21 @@
+# Микробенчмарк дедупликации вершин OBJ: std::unordered_map (прежняя реализация)
+# против VertexMap (core/vertexmap.h). В сборку приложения не входит:
+#   qmake bench/bench.pro && make && ./vertexmap_bench [путь к OBJ]
+
+QT -= core gui
+
+CONFIG += console c++17 release
+CONFIG -= app_bundle qt
+TEMPLATE = app
+TARGET = vertexmap_bench
+
+QMAKE_CXXFLAGS += -Wall -Wextra
+
+INCLUDEPATH += ..
+DEFINES += LHB_SOURCE_ROOT=\\\"$$PWD/..\\\"
+
+SOURCES += \
+    vertexmap_bench.cpp
+
+HEADERS += \
+    ../core/vertexmap.h
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/vertexmap.h"
+
+// Сравнение таблиц дедупликации вершин на потоке троек (v, vt, vn) после веерной
+// триангуляции - в том же виде, в каком их видит ObjLoader::loadParts:
+//   - boat.obj из ресурсов приложения;
+//   - синтетическая сетка 10M треугольников (решетка, каждая вершина - в 6 гранях).
+// Время - лучшее из нескольких повторов; память - пик кучи во время построения
+// (учитывается через глобальные operator new/delete, поток троек в нее не входит)
+
+namespace {
+
+// Учет памяти кучи
+size_t g_current = 0;
+size_t g_peak = 0;
+
+const int kRepeats = 3;
+const int kSyntheticCells = 2237; // 2 * 2237^2 = 10 008 338 треугольников
+
+// Перед блоком кучи хранится его размер (с выравниванием max_align_t)
+const size_t kHeader = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    char* p = static_cast<char*>(std::malloc(size + kHeader));
+    if (!p) throw std::bad_alloc();
+    std::memcpy(p, &size, sizeof(size));
+    g_current += size;
+    if (g_current > g_peak) g_peak = g_current;
+    return p + kHeader;
+}
+
+// Без встраивания: иначе GCC принимает смещение к заголовку блока за выход за границы
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* ptr) noexcept
+{
+    if (!ptr) return;
+    char* p = static_cast<char*>(ptr) - kHeader;
+    size_t size = 0;
+    std::memcpy(&size, p, sizeof(size));
+    g_current -= size;
+    std::free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+namespace {
+
+// Прежний ключ: поля по 21 бит, объединенные XOR
+long long packedKey(const VertexKey& k)
+{
+    return ((long long)k.v << 42) ^ ((long long)k.t << 21) ^ (long long)k.n;
+}
+
+struct Result
+{
+    double ms = 1e30;
+    size_t peakBytes = 0;
+    size_t unique = 0;
+};
+
+// Лучшее время из kRepeats; build(forEach) возвращает число уникальных вершин
+template <typename Build>
+Result measure(Build&& build)
+{
+    Result r;
+    for (int k = 0; k < kRepeats; ++k){
+        const size_t base = g_current;
+        g_peak = g_current;
+        const auto t0 = std::chrono::steady_clock::now();
+        r.unique = build();
+        const auto t1 = std::chrono::steady_clock::now();
+        r.ms = std::min(r.ms, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        r.peakBytes = g_peak - base;
+    }
+    return r;
+}
+
+template <typename ForEach>
+void runCase(const char* name, size_t corners, size_t maxAttr, ForEach&& forEach)
+{
+    std::printf("%s: %zu corners\n", name, corners);
+
+    // Стоимость самого потока троек (вычитается из остальных результатов)
+    const Result stream = measure([&]{
+        size_t sum = 0;
+        forEach([&](const VertexKey& k){ sum += k.v ^ k.t ^ k.n; });
+        return sum & 1;
+    });
+
+    const Result oldMap = measure([&]{
+        // Как до замены: find + emplace, без предварительного резервирования
+        std::unordered_map<long long, unsigned> remap;
+        unsigned next = 0;
+        forEach([&](const VertexKey& k){
+            const long long key = packedKey(k);
+            auto it = remap.find(key);
+            if (it == remap.end()) remap.emplace(key, next++);
+        });
+        return remap.size();
+    });
+
+    auto vertexMap = [&](bool reserve){
+        return measure([&]{
+            VertexMap remap;
+            if (reserve) remap.reserve(std::min(corners, maxAttr) + 1);
+            unsigned next = 0;
+            forEach([&](const VertexKey& k){
+                bool inserted = false;
+                remap.insert(k, next, inserted);
+                if (inserted) ++next;
+            });
+            return size_t(next);
+        });
+    };
+    const Result newMap = vertexMap(true);
+    const Result newMapNoReserve = vertexMap(false);
+
+    auto print = [&](const char* label, const Result& r){
+        std::printf("  %-28s %9.1f ms  %9.1f MB peak  %zu unique\n",
+                    label, std::max(0.0, r.ms - stream.ms), r.peakBytes / (1024.0 * 1024.0), r.unique);
+    };
+    std::printf("  %-28s %9.1f ms\n", "stream only", stream.ms);
+    print("unordered_map<long long>", oldMap);
+    print("VertexMap (reserve)", newMap);
+    print("VertexMap (no reserve)", newMapNoReserve);
+    std::printf("\n");
+}
+
+// Тройки граней OBJ: индексы приведены к глобальным (с учетом отрицательных),
+// полигоны разбиты веером
+bool loadObjCorners(const std::string& path, std::vector<VertexKey>& out, size_t& maxAttr)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+
+    int counts[3] = {0, 0, 0}; // v, vt, vn
+    std::string line;
+    std::vector<VertexKey> poly;
+    while (std::getline(in, line)){
+        if (line.compare(0, 2, "v ") == 0) ++counts[0];
+        else if (line.compare(0, 3, "vt ") == 0) ++counts[1];
+        else if (line.compare(0, 3, "vn ") == 0) ++counts[2];
+        else if (line.compare(0, 2, "f ") == 0){
+            poly.clear();
+            std::istringstream ss(line.substr(2));
+            std::string tok;
+            while (ss >> tok){
+                int idx[3] = {0, 0, 0};
+                size_t pos = 0;
+                for (int a = 0; a < 3 && pos <= tok.size(); ++a){
+                    const size_t slash = tok.find('/', pos);
+                    const std::string part = tok.substr(pos, slash == std::string::npos ? std::string::npos : slash - pos);
+                    if (!part.empty()){
+                        const int v = std::atoi(part.c_str());
+                        idx[a] = (v < 0) ? counts[a] + v + 1 : v; // 1-based, 0 - атрибута нет
+                    }
+                    if (slash == std::string::npos) break;
+                    pos = slash + 1;
+                }
+                poly.push_back(makeKey(idx[0] - 1, idx[1] - 1, idx[2] - 1));
+            }
+            for (size_t k = 2; k < poly.size(); ++k){
+                out.push_back(poly[0]);
+                out.push_back(poly[k - 1]);
+                out.push_back(poly[k]);
+            }
+        }
+    }
+    maxAttr = size_t(std::max(counts[0], std::max(counts[1], counts[2])));
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const std::string objPath = (argc > 1) ? argv[1] : std::string(LHB_SOURCE_ROOT) + "/assets/models/boat.obj";
+
+    std::vector<VertexKey> boat;
+    size_t boatAttr = 0;
+    if (loadObjCorners(objPath, boat, boatAttr)){
+        runCase(objPath.c_str(), boat.size(), boatAttr, [&](auto&& visit){
+            for (const VertexKey& k : boat) visit(k);
+        });
+    } else {
+        std::fprintf(stderr, "cannot open %s\n", objPath.c_str());
+    }
+    boat.clear();
+    boat.shrink_to_fit();
+
+    // Решетка (n + 1) x (n + 1) вершин, по два треугольника на ячейку; позиция,
+    // UV и нормаль вершины имеют один индекс, как в типичном экспорте
+    const int n = kSyntheticCells;
+    const size_t corners = size_t(n) * n * 6;
+    const size_t vertices = size_t(n + 1) * (n + 1);
+    runCase("synthetic grid", corners, vertices, [&](auto&& visit){
+        for (int y = 0; y < n; ++y){
+            for (int x = 0; x < n; ++x){
+                const int i0 = y * (n + 1) + x, i1 = i0 + 1, i2 = i0 + (n + 1), i3 = i2 + 1;
+                const int tri[6] = {i0, i1, i2, i1, i3, i2};
+                for (int i : tri) visit(makeKey(i, i, i));
+            }
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,242 @@
+#include "aabbtree.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+Vec3 minVec(const Vec3& a, const Vec3& b) { return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)}; }
+Vec3 maxVec(const Vec3& a, const Vec3& b) { return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)}; }
+
+bool contains(const Vec3& outerMin, const Vec3& outerMax, const Vec3& mn, const Vec3& mx)
+{
+    return outerMin.x <= mn.x && outerMin.y <= mn.y && outerMin.z <= mn.z
+        && mx.x <= outerMax.x && mx.y <= outerMax.y && mx.z <= outerMax.z;
+}
+
+} // namespace
+
+float AabbTree::area(const Vec3& mn, const Vec3& mx)
+{
+    const Vec3 d = mx - mn;
+    return 2.0f * (d.x*d.y + d.y*d.z + d.z*d.x);
+}
+
+bool AabbTree::overlaps(const Node& n, const Vec3& mn, const Vec3& mx)
+{
+    return n.min.x <= mx.x && mn.x <= n.max.x
+        && n.min.y <= mx.y && mn.y <= n.max.y
+        && n.min.z <= mx.z && mn.z <= n.max.z;
+}
+
+int AabbTree::allocateNode()
+{
+    if (m_free == kNull){
+        m_nodes.emplace_back();
+        return (int)m_nodes.size() - 1;
+    }
+    const int id = m_free;
+    m_free = m_nodes[id].parent;
+    m_nodes[id] = Node();
+    return id;
+}
+
+void AabbTree::freeNode(int node)
+{
+    m_nodes[node].parent = m_free;
+    m_nodes[node].height = -1;
+    m_free = node;
+}
+
+int AabbTree::insert(const Bounds& b, int userData)
+{
+    const int leaf = allocateNode();
+    Node& n = m_nodes[leaf];
+    const Vec3 margin{kFatMargin, kFatMargin, kFatMargin};
+    n.min = b.min - margin;
+    n.max = b.max + margin;
+    n.userData = userData;
+    n.height = 0;
+
+    insertLeaf(leaf);
+    ++m_leafCount;
+    return leaf;
+}
+
+void AabbTree::remove(int proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --m_leafCount;
+}
+
+bool AabbTree::update(int proxy, const Bounds& b)
+{
+    Node& n = m_nodes[proxy];
+    if (contains(n.min, n.max, b.min, b.max)) return false;
+
+    removeLeaf(proxy);
+    const Vec3 margin{kFatMargin, kFatMargin, kFatMargin};
+    n.min = b.min - margin;
+    n.max = b.max + margin;
+    insertLeaf(proxy);
+    return true;
+}
+
+void AabbTree::clear()
+{
+    m_nodes.clear();
+    m_root = kNull;
+    m_free = kNull;
+    m_leafCount = 0;
+}
+
+void AabbTree::insertLeaf(int leaf)
+{
+    if (m_root == kNull){
+        m_root = leaf;
+        m_nodes[leaf].parent = kNull;
+        return;
+    }
+
+    // Спуск к соседу: на каждом узле сравнивается стоимость нового родителя здесь
+    // со стоимостью спуска в каждого из потомков (прирост площадей предков учтен в inherited)
+    const Vec3 leafMin = m_nodes[leaf].min;
+    const Vec3 leafMax = m_nodes[leaf].max;
+    int index = m_root;
+    while (!m_nodes[index].isLeaf()){
+        const Node& n = m_nodes[index];
+        const float nodeArea = area(n.min, n.max);
+        const float combinedArea = area(minVec(n.min, leafMin), maxVec(n.max, leafMax));
+
+        const float cost = 2.0f * combinedArea;
+        const float inherited = 2.0f * (combinedArea - nodeArea);
+
+        auto descendCost = [&](int child){
+            const Node& c = m_nodes[child];
+            const float a = area(minVec(c.min, leafMin), maxVec(c.max, leafMax));
+            return c.isLeaf() ? a + inherited : (a - area(c.min, c.max)) + inherited;
+        };
+        const float cost1 = descendCost(n.child1);
+        const float cost2 = descendCost(n.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = (cost1 < cost2) ? n.child1 : n.child2;
+    }
+
+    // Новый родитель для соседа и листа
+    const int sibling = index;
+    const int oldParent = m_nodes[sibling].parent;
+    const int newParent = allocateNode();
+    {
+        Node& p = m_nodes[newParent];
+        p.parent = oldParent;
+        p.min = minVec(m_nodes[sibling].min, leafMin);
+        p.max = maxVec(m_nodes[sibling].max, leafMax);
+        p.height = m_nodes[sibling].height + 1;
+        p.child1 = sibling;
+        p.child2 = leaf;
+    }
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent == kNull){
+        m_root = newParent;
+    } else if (m_nodes[oldParent].child1 == sibling){
+        m_nodes[oldParent].child1 = newParent;
+    } else {
+        m_nodes[oldParent].child2 = newParent;
+    }
+
+    refit(newParent);
+}
+
+void AabbTree::removeLeaf(int leaf)
+{
+    if (leaf == m_root){
+        m_root = kNull;
+        return;
+    }
+
+    // Родитель удаляется, сосед занимает его место
+    const int parent = m_nodes[leaf].parent;
+    const int grandParent = m_nodes[parent].parent;
+    const int sibling = (m_nodes[parent].child1 == leaf) ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if (grandParent == kNull){
+        m_root = sibling;
+        m_nodes[sibling].parent = kNull;
+        freeNode(parent);
+        return;
+    }
+
+    if (m_nodes[grandParent].child1 == parent) m_nodes[grandParent].child1 = sibling;
+    else m_nodes[grandParent].child2 = sibling;
+    m_nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refit(grandParent);
+}
+
+void AabbTree::refit(int node)
+{
+    // Уточнение границ и высот предков с балансировкой по пути к корню
+    for (int index = node; index != kNull; index = m_nodes[index].parent){
+        index = balance(index);
+
+        Node& n = m_nodes[index];
+        const Node& c1 = m_nodes[n.child1];
+        const Node& c2 = m_nodes[n.child2];
+        n.min = minVec(c1.min, c2.min);
+        n.max = maxVec(c1.max, c2.max);
+        n.height = 1 + std::max(c1.height, c2.height);
+    }
+}
+
+int AabbTree::balance(int iA)
+{
+    // Поворот, если высоты поддеревьев A отличаются больше чем на 1:
+    // более высокий потомок поднимается на место A. Возвращает новый корень поддерева
+    Node& A = m_nodes[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    const int iB = A.child1;
+    const int iC = A.child2;
+    const int diff = m_nodes[iC].height - m_nodes[iB].height;
+    if (diff >= -1 && diff <= 1) return iA;
+
+    const int iUp = (diff > 1) ? iC : iB;   // Поднимаемый потомок
+    const int iStay = (diff > 1) ? iB : iC; // Остающийся у A
+    Node& up = m_nodes[iUp];
+    const int iF = up.child1;
+    const int iG = up.child2;
+
+    // up занимает место A
+    up.child1 = iA;
+    up.parent = A.parent;
+    A.parent = iUp;
+    if (up.parent == kNull) m_root = iUp;
+    else if (m_nodes[up.parent].child1 == iA) m_nodes[up.parent].child1 = iUp;
+    else m_nodes[up.parent].child2 = iUp;
+
+    // Более высокий внук остается у up, другой переходит к A
+    const bool keepF = m_nodes[iF].height > m_nodes[iG].height;
+    const int iKeep = keepF ? iF : iG;
+    const int iMove = keepF ? iG : iF;
+    up.child2 = iKeep;
+    A.child1 = iStay;
+    A.child2 = iMove;
+    m_nodes[iMove].parent = iA;
+
+    const Node& s = m_nodes[iStay];
+    const Node& mv = m_nodes[iMove];
+    A.min = minVec(s.min, mv.min);
+    A.max = maxVec(s.max, mv.max);
+    A.height = 1 + std::max(s.height, mv.height);
+
+    const Node& k = m_nodes[iKeep];
+    up.min = minVec(A.min, k.min);
+    up.max = maxVec(A.max, k.max);
+    up.height = 1 + std::max(A.height, k.height);
+    return iUp;
+}
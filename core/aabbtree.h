@@ -0,0 +1,156 @@
+#ifndef AABBTREE_H
+#define AABBTREE_H
+
+#include <vector>
+
+#include "bounds.h"
+#include "frustum.h"
+
+// Динамическое дерево AABB (BVH) для движущихся объектов.
+// Листья хранят расширенные границы (kFatMargin): пока объект не вышел за них,
+// update ничего не меняет; иначе лист вынимается и вставляется заново.
+// Вставка выбирает соседа по эвристике площади поверхности (SAH), после чего
+// предки уточняются снизу вверх и балансируются поворотами.
+// userData - произвольный номер, который дерево возвращает в запросах
+
+class AabbTree
+{
+public:
+    static constexpr int kNull = -1;
+    static constexpr float kFatMargin = 0.5f; // Запас расширенных границ (мировые единицы)
+
+    int insert(const Bounds& b, int userData);
+    void remove(int proxy);
+
+    // Новые точные границы листа; true, если лист пришлось переставить
+    bool update(int proxy, const Bounds& b);
+
+    void clear();
+
+    int userData(int proxy) const { return m_nodes[proxy].userData; }
+    Vec3 fatMin(int proxy) const { return m_nodes[proxy].min; }
+    Vec3 fatMax(int proxy) const { return m_nodes[proxy].max; }
+
+    int height() const { return m_root == kNull ? 0 : m_nodes[m_root].height; }
+    int leafCount() const { return m_leafCount; }
+
+    // visit(proxy) для листьев, пересекающих box; visit возвращает false для остановки
+    template <typename Visit>
+    void query(const Vec3& boxMin, const Vec3& boxMax, Visit&& visit) const;
+
+    // visit(proxy, inside) для листьев, пересекающих пирамиду; inside - лист
+    // заведомо внутри (его предок целиком в пирамиде), дальнейшая проверка не нужна
+    template <typename Visit>
+    void query(const Frustum& frustum, Visit&& visit) const;
+
+    // visit(proxy, tEntry) -> новое ограничение дальности луча (tEntry - вход луча
+    // в расширенные границы листа); узлы дальше ограничения пропускаются
+    template <typename Visit>
+    void raycast(const Vec3& origin, const Vec3& dir, float maxT, Visit&& visit) const;
+
+private:
+    struct Node
+    {
+        Vec3 min, max;
+        int parent = kNull; // Для свободных узлов - следующий свободный
+        int child1 = kNull;
+        int child2 = kNull;
+        int height = 0;     // Лист - 0, свободный узел - -1
+        int userData = -1;
+
+        bool isLeaf() const { return child1 == kNull; }
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int a);
+    void refit(int node);
+
+    static float area(const Vec3& mn, const Vec3& mx);
+    static bool overlaps(const Node& n, const Vec3& mn, const Vec3& mx);
+
+    std::vector<Node> m_nodes;
+    int m_root = kNull;
+    int m_free = kNull;
+    int m_leafCount = 0;
+
+    mutable std::vector<int> m_stack; // Обход без выделения памяти в каждом запросе
+};
+
+template <typename Visit>
+void AabbTree::query(const Vec3& boxMin, const Vec3& boxMax, Visit&& visit) const
+{
+    if (m_root == kNull) return;
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty()){
+        const int id = m_stack.back();
+        m_stack.pop_back();
+        const Node& n = m_nodes[id];
+        if (!overlaps(n, boxMin, boxMax)) continue;
+        if (n.isLeaf()){
+            if (!visit(id)) return;
+        } else {
+            m_stack.push_back(n.child1);
+            m_stack.push_back(n.child2);
+        }
+    }
+}
+
+template <typename Visit>
+void AabbTree::query(const Frustum& frustum, Visit&& visit) const
+{
+    if (m_root == kNull) return;
+
+    // Знак в стеке - поддерево целиком внутри пирамиды (узел id хранится как ~id)
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty()){
+        int id = m_stack.back();
+        m_stack.pop_back();
+
+        bool inside = id < 0;
+        if (inside) id = ~id;
+        const Node& n = m_nodes[id];
+        if (!inside){
+            const Frustum::Containment c = frustum.classify(n.min, n.max);
+            if (c == Frustum::Containment::Outside) continue;
+            inside = (c == Frustum::Containment::Inside);
+        }
+        if (n.isLeaf()){
+            visit(id, inside);
+        } else {
+            m_stack.push_back(inside ? ~n.child1 : n.child1);
+            m_stack.push_back(inside ? ~n.child2 : n.child2);
+        }
+    }
+}
+
+template <typename Visit>
+void AabbTree::raycast(const Vec3& origin, const Vec3& dir, float maxT, Visit&& visit) const
+{
+    if (m_root == kNull) return;
+
+    const Vec3 invDir = rayInverse(dir);
+
+    m_stack.clear();
+    m_stack.push_back(m_root);
+    while (!m_stack.empty()){
+        const int id = m_stack.back();
+        m_stack.pop_back();
+        const Node& n = m_nodes[id];
+        float tEntry = 0.0f;
+        if (!rayBoxEntry(n.min, n.max, origin, invDir, maxT, tEntry)) continue;
+        if (n.isLeaf()){
+            maxT = std::min(maxT, visit(id, tEntry));
+        } else {
+            m_stack.push_back(n.child1);
+            m_stack.push_back(n.child2);
+        }
+    }
+}
+
+#endif // AABBTREE_H
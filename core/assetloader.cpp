@@ -0,0 +1,67 @@
+#include "assetloader.h"
+
+#include <algorithm>
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+
+AssetLoader& AssetLoader::instance()
+{
+    static AssetLoader loader;
+    return loader;
+}
+
+AssetLoader::AssetLoader()
+{
+    // Один поток оставляется GUI-потоку
+    m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+AssetLoader::~AssetLoader()
+{
+    m_pool.waitForDone();
+}
+
+void AssetLoader::run(std::function<void()> job)
+{
+    ++m_running;
+    m_pool.start([this, job = std::move(job)](){
+        job();
+        --m_running;
+    });
+}
+
+void AssetLoader::post(Upload upload)
+{
+    QMutexLocker<QMutex> lock(&m_mutex);
+    m_ready.push_back(std::move(upload));
+}
+
+int AssetLoader::pump(QOpenGLFunctions_3_3_Core* f, double budgetMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 budgetNs = qint64(budgetMs * 1e6);
+
+    int done = 0;
+    for (;;){
+        Upload next;
+        {
+            QMutexLocker<QMutex> lock(&m_mutex);
+            if (m_ready.empty()) break;
+            next = std::move(m_ready.front());
+            m_ready.pop_front();
+        }
+        next(f);
+        ++done;
+        if (timer.nsecsElapsed() >= budgetNs) break;
+    }
+    return done;
+}
+
+bool AssetLoader::idle() const
+{
+    QMutexLocker<QMutex> lock(&m_mutex);
+    return m_ready.empty() && m_running.load() == 0;
+}
@@ -0,0 +1,48 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+
+#include <QMutex>
+#include <QThreadPool>
+
+class QOpenGLFunctions_3_3_Core;
+
+// Фоновая загрузка ресурсов:
+// - разбор моделей и декодирование изображений выполняются в пуле рабочих потоков;
+// - готовые CPU-данные публикуются в очередь выгрузок в виде функций;
+// - GL-поток выполняет выгрузки в начале кадра, не превышая бюджет времени.
+
+class AssetLoader
+{
+public:
+    using Upload = std::function<void(QOpenGLFunctions_3_3_Core*)>;
+
+    static AssetLoader& instance();
+
+    // Запуск задачи в рабочем потоке
+    void run(std::function<void()> job);
+
+    // Публикация выгрузки для GL-потока (можно вызывать из любого потока)
+    void post(Upload upload);
+
+    // Выполнение выгрузок в GL-потоке; не менее одной за вызов, далее - пока не исчерпан бюджет.
+    // Возвращает число выполненных выгрузок
+    int pump(QOpenGLFunctions_3_3_Core* f, double budgetMs);
+
+    // Нет ни выполняющихся задач, ни ожидающих выгрузок
+    bool idle() const;
+
+private:
+    AssetLoader();
+    ~AssetLoader();
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    std::deque<Upload> m_ready;
+    std::atomic<int> m_running{0};
+};
+
+#endif // ASSETLOADER_H
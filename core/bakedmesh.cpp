@@ -0,0 +1,272 @@
+#include "bakedmesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable");
+static_assert(sizeof(Vertex) == 32, "Vertex layout changed, bump kVersion");
+
+namespace {
+
+const char kMagic[4] = {'L','H','B','M'};
+const quint32 kVersion = 3;
+const quint32 kByteOrderMark = 0x01020304u;
+const int kHashSize = 16; // MD5
+
+struct Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 vertexSize;
+    quint32 partCount;
+    quint32 reserved;
+    quint64 fileSize;
+    quint8 hash[kHashSize];
+};
+
+// Строки материала: имя, map_Kd, map_Ks, map_Kn
+enum { StrName, StrMapKd, StrMapKs, StrMapKn, StrCount };
+
+struct PartRecord
+{
+    quint64 vertexOffset;
+    quint64 indexOffset;
+    quint32 vertexCount;
+    quint32 indexCount;
+
+    float ka[3];
+    float kd[3];
+    float ks[3];
+    float ns;
+    float d;
+    qint32 illum;
+    quint32 useTexture;
+
+    quint32 strOffset[StrCount];
+    quint32 strLength[StrCount];
+
+    // Уровни детализации - диапазоны массива индексов части
+    quint32 lodCount;
+    quint32 lodIndexOffset[Mesh::kMaxLods];
+    quint32 lodIndexCount[Mesh::kMaxLods];
+    float lodError[Mesh::kMaxLods];
+
+    float boundsMin[3];
+    float boundsMax[3];
+    float sphereCenter[3];
+    float sphereRadius;
+};
+
+quint64 alignUp(quint64 v, quint64 a) { return (v + a - 1) & ~(a - 1); }
+
+void putVec3(float* dst, const Vec3& v) { dst[0] = v.x; dst[1] = v.y; dst[2] = v.z; }
+Vec3 getVec3(const float* src) { return {src[0], src[1], src[2]}; }
+
+} // namespace
+
+QByteArray BakedMesh::sourceHash(const QString& objPath, const QString& salt)
+{
+    QCryptographicHash h(QCryptographicHash::Md5);
+    h.addData(salt.toUtf8());
+
+    auto addFile = [&](const QString& path){
+        MappedFile file;
+        if (!file.open(path)) return;
+        h.addData(path.toUtf8());
+        h.addData(QByteArrayView(file.data(), qsizetype(file.size())));
+    };
+
+    addFile(objPath);
+    for (const QString& mtl : ObjLoader::materialLibraries(objPath)) addFile(mtl);
+    return h.result();
+}
+
+QString BakedMesh::cacheFilePath(const QString& key)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/meshes";
+    const QByteArray name = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + "/" + QString::fromLatin1(name.constData(), name.size()) + ".lhbm";
+}
+
+bool BakedMesh::write(const QString& file, const QByteArray& hash, const std::vector<ObjLoader::ObjPart>& parts)
+{
+    if (hash.size() != kHashSize) return false;
+
+    // Раскладка: заголовок, таблица частей, массивы данных, строки
+    quint64 offset = alignUp(sizeof(Header) + parts.size() * sizeof(PartRecord), 16);
+
+    std::vector<PartRecord> records(parts.size());
+    std::vector<QByteArray> strings;
+    for (size_t k = 0; k < parts.size(); ++k){
+        const auto& p = parts[k];
+        PartRecord& r = records[k];
+        std::memset(&r, 0, sizeof(r));
+
+        r.vertexCount = quint32(p.vertices.size());
+        r.indexCount  = quint32(p.indices.size());
+        r.vertexOffset = offset;
+        offset = alignUp(offset + p.vertices.size() * sizeof(Vertex), 16);
+        r.indexOffset = offset;
+        offset = alignUp(offset + p.indices.size() * sizeof(unsigned), 16);
+
+        const auto& m = p.material;
+        putVec3(r.ka, m.ka);
+        putVec3(r.kd, m.kd);
+        putVec3(r.ks, m.ks);
+        r.ns = m.ns;
+        r.d = m.d;
+        r.illum = m.illum;
+        r.useTexture = m.useTexture ? 1u : 0u;
+
+        r.lodCount = quint32(std::min<size_t>(p.lods.size(), Mesh::kMaxLods));
+        for (quint32 l = 0; l < r.lodCount; ++l){
+            r.lodIndexOffset[l] = p.lods[l].indexOffset;
+            r.lodIndexCount[l]  = p.lods[l].indexCount;
+            r.lodError[l]       = p.lods[l].error;
+        }
+
+        putVec3(r.boundsMin, p.bounds.min);
+        putVec3(r.boundsMax, p.bounds.max);
+        putVec3(r.sphereCenter, p.bounds.center);
+        r.sphereRadius = p.bounds.radius;
+
+        const QString* src[StrCount] = {&m.name, &m.mapKd, &m.mapKs, &m.mapKn};
+        for (int s = 0; s < StrCount; ++s){
+            strings.push_back(src[s]->toUtf8());
+            r.strLength[s] = quint32(strings.back().size());
+        }
+    }
+
+    // Строки размещаются в конце файла
+    size_t strIdx = 0;
+    for (auto& r : records){
+        for (int s = 0; s < StrCount; ++s){
+            r.strOffset[s] = quint32(offset);
+            offset += strings[strIdx++].size();
+        }
+    }
+
+    Header hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, kMagic, 4);
+    hdr.version = kVersion;
+    hdr.byteOrder = kByteOrderMark;
+    hdr.vertexSize = sizeof(Vertex);
+    hdr.partCount = quint32(parts.size());
+    hdr.fileSize = offset;
+    std::memcpy(hdr.hash, hash.constData(), kHashSize);
+
+    QByteArray blob(int(offset), 0);
+    char* out = blob.data();
+    std::memcpy(out, &hdr, sizeof(hdr));
+    if (!records.empty()) std::memcpy(out + sizeof(hdr), records.data(), records.size() * sizeof(PartRecord));
+    for (size_t k = 0; k < parts.size(); ++k){
+        const auto& p = parts[k];
+        const auto& r = records[k];
+        if (!p.vertices.empty()) std::memcpy(out + r.vertexOffset, p.vertices.data(), p.vertices.size() * sizeof(Vertex));
+        if (!p.indices.empty())  std::memcpy(out + r.indexOffset,  p.indices.data(),  p.indices.size()  * sizeof(unsigned));
+    }
+    strIdx = 0;
+    for (const auto& r : records){
+        for (int s = 0; s < StrCount; ++s){
+            const QByteArray& str = strings[strIdx++];
+            if (!str.isEmpty()) std::memcpy(out + r.strOffset[s], str.constData(), str.size());
+        }
+    }
+
+    QDir().mkpath(QFileInfo(file).dir().absolutePath());
+
+    // Запись через временный файл: недописанный кеш никогда не окажется на месте готового
+    QSaveFile sf(file);
+    if (!sf.open(QIODevice::WriteOnly)) return false;
+    if (sf.write(blob) != blob.size()) return false;
+    return sf.commit();
+}
+
+bool BakedMesh::open(const QString& file, const QByteArray& expectedHash)
+{
+    close();
+    if (expectedHash.size() != kHashSize) return false;
+    if (!m_file.open(file)) return false;
+
+    const char* base = m_file.data();
+    const quint64 size = quint64(m_file.size());
+
+    auto fail = [&](){ close(); return false; };
+
+    if (size < sizeof(Header)) return fail();
+    Header hdr;
+    std::memcpy(&hdr, base, sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, kMagic, 4) != 0) return fail();
+    if (hdr.version != kVersion || hdr.byteOrder != kByteOrderMark) return fail();
+    if (hdr.vertexSize != sizeof(Vertex) || hdr.fileSize != size) return fail();
+    if (std::memcmp(hdr.hash, expectedHash.constData(), kHashSize) != 0) return fail();
+    if (sizeof(Header) + quint64(hdr.partCount) * sizeof(PartRecord) > size) return fail();
+
+    // Массивы передаются в GL по указателю, поэтому требуется выравнивание данных
+    if ((reinterpret_cast<quintptr>(base) & 15u) != 0) return fail();
+
+    auto inRange = [&](quint64 off, quint64 bytes){ return off <= size && bytes <= size - off; };
+
+    m_parts.reserve(hdr.partCount);
+    for (quint32 k = 0; k < hdr.partCount; ++k){
+        PartRecord r;
+        std::memcpy(&r, base + sizeof(Header) + k * sizeof(PartRecord), sizeof(r));
+
+        if (!inRange(r.vertexOffset, quint64(r.vertexCount) * sizeof(Vertex))) return fail();
+        if (!inRange(r.indexOffset,  quint64(r.indexCount)  * sizeof(unsigned))) return fail();
+        if ((r.vertexOffset & 15u) != 0 || (r.indexOffset & 15u) != 0) return fail();
+
+        PartView v;
+        v.vertices = reinterpret_cast<const Vertex*>(base + r.vertexOffset);
+        v.vertexCount = r.vertexCount;
+        v.indices = reinterpret_cast<const unsigned*>(base + r.indexOffset);
+        v.indexCount = r.indexCount;
+
+        QString* dst[StrCount] = {&v.material.name, &v.material.mapKd, &v.material.mapKs, &v.material.mapKn};
+        for (int s = 0; s < StrCount; ++s){
+            if (!inRange(r.strOffset[s], r.strLength[s])) return fail();
+            *dst[s] = QString::fromUtf8(base + r.strOffset[s], int(r.strLength[s]));
+        }
+
+        v.material.ka = getVec3(r.ka);
+        v.material.kd = getVec3(r.kd);
+        v.material.ks = getVec3(r.ks);
+        v.material.ns = r.ns;
+        v.material.d = r.d;
+        v.material.illum = r.illum;
+        v.material.useTexture = (r.useTexture != 0);
+
+        if (r.lodCount > quint32(Mesh::kMaxLods)) return fail();
+        for (quint32 l = 0; l < r.lodCount; ++l){
+            if (quint64(r.lodIndexOffset[l]) + r.lodIndexCount[l] > r.indexCount) return fail();
+            MeshLod lod;
+            lod.indexOffset = r.lodIndexOffset[l];
+            lod.indexCount  = r.lodIndexCount[l];
+            lod.error       = r.lodError[l];
+            v.lods.push_back(lod);
+        }
+
+        v.bounds.min = getVec3(r.boundsMin);
+        v.bounds.max = getVec3(r.boundsMax);
+        v.bounds.center = getVec3(r.sphereCenter);
+        v.bounds.radius = r.sphereRadius;
+        m_parts.push_back(std::move(v));
+    }
+    return true;
+}
+
+void BakedMesh::close()
+{
+    m_parts.clear();
+    m_file.close();
+}
@@ -0,0 +1,51 @@
+#ifndef BAKEDMESH_H
+#define BAKEDMESH_H
+
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include "mappedfile.h"
+#include "objloader.h"
+
+// Двоичный кеш запеченных моделей (.lhbm): результат ObjLoader::loadParts после
+// предобработки модели (повороты, нормализация), который передается в Mesh::upload
+// прямо из отображенного в память файла, без разбора текста.
+//
+// Раскладка файла (порядок байт платформы, массивы выровнены на 16 байт):
+//   Header | PartRecord[partCount] | вершины и индексы частей | таблица строк материалов
+
+class BakedMesh
+{
+public:
+    struct PartView {
+        const Vertex* vertices = nullptr;
+        size_t vertexCount = 0;
+        const unsigned* indices = nullptr;
+        size_t indexCount = 0;
+        ObjLoader::Material material;
+        std::vector<MeshLod> lods;
+        Bounds bounds;
+    };
+
+    // Хеш исходных данных: содержимое OBJ, подключенных MTL и строка параметров предобработки
+    static QByteArray sourceHash(const QString& objPath, const QString& salt);
+
+    // Путь к файлу кеша в пользовательском каталоге кеша для заданного ключа модели
+    static QString cacheFilePath(const QString& key);
+
+    static bool write(const QString& file, const QByteArray& hash, const std::vector<ObjLoader::ObjPart>& parts);
+
+    // Открытие кеша; false, если файла нет, он поврежден или устарел (хеш не совпал)
+    bool open(const QString& file, const QByteArray& expectedHash);
+    void close();
+
+    const std::vector<PartView>& parts() const { return m_parts; }
+
+private:
+    MappedFile m_file;
+    std::vector<PartView> m_parts;
+};
+
+#endif // BAKEDMESH_H
@@ -0,0 +1,367 @@
+#include "bakedtexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "blockcompression.h"
+
+namespace {
+
+const char kMagic[4] = {'L','H','B','T'};
+const quint32 kVersion = 1;
+const quint32 kByteOrderMark = 0x01020304u;
+const int kHashSize = 16; // MD5
+const int kMaxLevels = 16;
+
+struct Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 format;
+    quint32 srgb;
+    quint32 width;
+    quint32 height;
+    quint32 levelCount;
+    quint64 fileSize;
+    quint8 hash[kHashSize];
+};
+
+struct LevelRecord
+{
+    quint64 offset;
+    quint64 size;
+    quint32 width;
+    quint32 height;
+};
+
+quint64 alignUp(quint64 v, quint64 a) { return (v + a - 1) & ~(a - 1); }
+
+int blockBytes(BakedTexture::Format format)
+{
+    return format == BakedTexture::Format::BC1 ? 8 : 16;
+}
+
+size_t levelBytes(BakedTexture::Format format, int w, int h)
+{
+    if (format == BakedTexture::Format::RGBA8) return size_t(w) * size_t(h) * 4;
+    return size_t((w + 3) / 4) * size_t((h + 3) / 4) * blockBytes(format);
+}
+
+// Уровень в линейном пространстве (RGBA, float), в котором усредняются мип-уровни
+struct LinearImage
+{
+    int w = 0, h = 0;
+    std::vector<float> px;
+
+    float* at(int x, int y) { return &px[(size_t(y) * w + x) * 4]; }
+    const float* at(int x, int y) const { return &px[(size_t(y) * w + x) * 4]; }
+};
+
+float srgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+uint8_t toByte(float v)
+{
+    return uint8_t(std::lround(std::max(0.0f, std::min(1.0f, v)) * 255.0f));
+}
+
+LinearImage toLinear(const QImage& img, bool srgb, TextureUsage usage)
+{
+    float lut[256];
+    for (int i = 0; i < 256; ++i){
+        const float c = i / 255.0f;
+        lut[i] = usage == TextureUsage::Normal ? c * 2.0f - 1.0f : (srgb ? srgbToLinear(c) : c);
+    }
+
+    LinearImage out;
+    out.w = img.width();
+    out.h = img.height();
+    out.px.resize(size_t(out.w) * out.h * 4);
+    for (int y = 0; y < out.h; ++y){
+        const uchar* row = img.constScanLine(y);
+        for (int x = 0; x < out.w; ++x){
+            float* p = out.at(x, y);
+            for (int c = 0; c < 3; ++c) p[c] = lut[row[x * 4 + c]];
+            p[3] = row[x * 4 + 3] / 255.0f;
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> toBytes(const LinearImage& img, bool srgb, TextureUsage usage)
+{
+    std::vector<uint8_t> out(size_t(img.w) * img.h * 4);
+    for (size_t i = 0; i < size_t(img.w) * img.h; ++i){
+        const float* p = &img.px[i * 4];
+        for (int c = 0; c < 3; ++c){
+            const float v = usage == TextureUsage::Normal ? p[c] * 0.5f + 0.5f : (srgb ? linearToSrgb(p[c]) : p[c]);
+            out[i * 4 + c] = toByte(v);
+        }
+        out[i * 4 + 3] = toByte(p[3]);
+    }
+    return out;
+}
+
+// Прямоугольный фильтр 2x2 (у нечетной стороны крайний столбец/строка повторяется)
+LinearImage downsample(const LinearImage& src, TextureUsage usage)
+{
+    LinearImage dst;
+    dst.w = std::max(1, src.w / 2);
+    dst.h = std::max(1, src.h / 2);
+    dst.px.resize(size_t(dst.w) * dst.h * 4);
+
+    for (int y = 0; y < dst.h; ++y){
+        const int y0 = std::min(y * 2, src.h - 1), y1 = std::min(y * 2 + 1, src.h - 1);
+        for (int x = 0; x < dst.w; ++x){
+            const int x0 = std::min(x * 2, src.w - 1), x1 = std::min(x * 2 + 1, src.w - 1);
+            const float* a = src.at(x0, y0);
+            const float* b = src.at(x1, y0);
+            const float* c = src.at(x0, y1);
+            const float* d = src.at(x1, y1);
+            float* p = dst.at(x, y);
+            for (int k = 0; k < 4; ++k) p[k] = (a[k] + b[k] + c[k] + d[k]) * 0.25f;
+
+            if (usage == TextureUsage::Normal){
+                // Среднее единичных векторов короче единицы - перенормировка
+                const float len = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+                if (len > 1e-6f){ p[0] /= len; p[1] /= len; p[2] /= len; }
+                else { p[0] = 0.0f; p[1] = 0.0f; p[2] = 1.0f; }
+            }
+        }
+    }
+    return dst;
+}
+
+void compressLevel(const std::vector<uint8_t>& rgba, int w, int h, BakedTexture::Format format, uint8_t* out)
+{
+    const int bw = (w + 3) / 4, bh = (h + 3) / 4;
+    const int bytes = blockBytes(format);
+    uint8_t block[64];
+
+    for (int by = 0; by < bh; ++by){
+        for (int bx = 0; bx < bw; ++bx){
+            // Блок на краю уровня дополняется повтором крайних пикселей
+            for (int j = 0; j < 4; ++j){
+                const int y = std::min(by * 4 + j, h - 1);
+                for (int i = 0; i < 4; ++i){
+                    const int x = std::min(bx * 4 + i, w - 1);
+                    std::memcpy(block + (j * 4 + i) * 4, &rgba[(size_t(y) * w + x) * 4], 4);
+                }
+            }
+            switch (format){
+            case BakedTexture::Format::BC1: BlockCompression::encodeBC1(block, out); break;
+            case BakedTexture::Format::BC3: BlockCompression::encodeBC3(block, out); break;
+            case BakedTexture::Format::BC5: BlockCompression::encodeBC5(block, out); break;
+            case BakedTexture::Format::RGBA8: break;
+            }
+            out += bytes;
+        }
+    }
+}
+
+} // namespace
+
+QString BakedTexture::cacheFilePath(const QString& key)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures";
+    const QByteArray name = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
+    return dir + "/" + QString::fromLatin1(name.constData(), name.size()) + ".lhbt";
+}
+
+QByteArray BakedTexture::sourceHash(const QString& path, const QString& salt)
+{
+    MappedFile file;
+    if (!file.open(path)) return QByteArray();
+
+    QCryptographicHash h(QCryptographicHash::Md5);
+    h.addData(salt.toUtf8());
+    h.addData(QByteArrayView(file.data(), qsizetype(file.size())));
+    return h.result();
+}
+
+bool BakedTexture::load(const QString& path, bool srgb, TextureUsage usage)
+{
+    close();
+
+    const QString key = QString("%1|%2|%3").arg(path).arg(srgb ? 1 : 0).arg(int(usage));
+    const QByteArray hash = sourceHash(path, key + QString("|v%1").arg(kVersion));
+    if (hash.isEmpty()) return false;
+
+    const QString file = cacheFilePath(key);
+    if (m_file.open(file)){
+        if (parse(m_file.data(), quint64(m_file.size()), hash)) return true;
+        close();
+    }
+
+    if (!bake(path, hash, srgb, usage)) return false;
+    if (!parse(m_blob.constData(), quint64(m_blob.size()), hash)){
+        close();
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(file).dir().absolutePath());
+
+    // Запись через временный файл: недописанный кеш никогда не окажется на месте готового
+    QSaveFile sf(file);
+    if (sf.open(QIODevice::WriteOnly) && sf.write(m_blob) == m_blob.size()) sf.commit();
+    return true;
+}
+
+void BakedTexture::close()
+{
+    m_levels.clear();
+    m_blob = QByteArray();
+    m_file.close();
+}
+
+bool BakedTexture::bake(const QString& path, const QByteArray& hash, bool srgb, TextureUsage usage)
+{
+    QImage img(path);
+    if (img.isNull()) return false;
+    // OpenGL ожидает первую строку снизу
+    img = img.mirrored(false, true).convertToFormat(QImage::Format_RGBA8888);
+
+    // Мип-уровни вычисляются в линейном пространстве (цвет sRGB) или как векторы (нормали)
+    std::vector<LinearImage> chain;
+    chain.push_back(toLinear(img, srgb, usage));
+    while ((chain.back().w > 1 || chain.back().h > 1) && (int)chain.size() < kMaxLevels){
+        chain.push_back(downsample(chain.back(), usage));
+    }
+
+    std::vector<std::vector<uint8_t>> bytes;
+    bytes.reserve(chain.size());
+    for (const auto& level : chain) bytes.push_back(toBytes(level, srgb, usage));
+
+    Format format = Format::BC5;
+    if (usage == TextureUsage::Color){
+        const auto& base = bytes[0];
+        bool opaque = true;
+        for (size_t i = 3; i < base.size() && opaque; i += 4) opaque = (base[i] == 255);
+        format = opaque ? Format::BC1 : Format::BC3;
+    }
+    // Изображение меньше одного блока сжимать нет смысла
+    if (img.width() < 4 || img.height() < 4) format = Format::RGBA8;
+
+    std::vector<LevelRecord> records(chain.size());
+    quint64 offset = alignUp(sizeof(Header) + records.size() * sizeof(LevelRecord), 16);
+    for (size_t l = 0; l < chain.size(); ++l){
+        LevelRecord& r = records[l];
+        std::memset(&r, 0, sizeof(r));
+        r.width = quint32(chain[l].w);
+        r.height = quint32(chain[l].h);
+        r.size = levelBytes(format, chain[l].w, chain[l].h);
+        r.offset = offset;
+        offset = alignUp(offset + r.size, 16);
+    }
+
+    Header hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, kMagic, 4);
+    hdr.version = kVersion;
+    hdr.byteOrder = kByteOrderMark;
+    hdr.format = quint32(format);
+    hdr.srgb = srgb ? 1u : 0u;
+    hdr.width = quint32(img.width());
+    hdr.height = quint32(img.height());
+    hdr.levelCount = quint32(records.size());
+    hdr.fileSize = offset;
+    std::memcpy(hdr.hash, hash.constData(), kHashSize);
+
+    m_blob = QByteArray(int(offset), 0);
+    char* out = m_blob.data();
+    std::memcpy(out, &hdr, sizeof(hdr));
+    std::memcpy(out + sizeof(hdr), records.data(), records.size() * sizeof(LevelRecord));
+    for (size_t l = 0; l < records.size(); ++l){
+        uint8_t* dst = reinterpret_cast<uint8_t*>(out + records[l].offset);
+        if (format == Format::RGBA8) std::memcpy(dst, bytes[l].data(), bytes[l].size());
+        else compressLevel(bytes[l], chain[l].w, chain[l].h, format, dst);
+    }
+    return true;
+}
+
+bool BakedTexture::parse(const char* base, quint64 size, const QByteArray& expectedHash)
+{
+    if (expectedHash.size() != kHashSize || size < sizeof(Header)) return false;
+    Header hdr;
+    std::memcpy(&hdr, base, sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, kMagic, 4) != 0) return false;
+    if (hdr.version != kVersion || hdr.byteOrder != kByteOrderMark) return false;
+    if (hdr.fileSize != size || hdr.format > quint32(Format::BC5)) return false;
+    if (std::memcmp(hdr.hash, expectedHash.constData(), kHashSize) != 0) return false;
+    if (hdr.levelCount == 0 || hdr.levelCount > quint32(kMaxLevels)) return false;
+    if (sizeof(Header) + quint64(hdr.levelCount) * sizeof(LevelRecord) > size) return false;
+
+    const Format format = Format(hdr.format);
+    std::vector<Level> levels;
+    for (quint32 l = 0; l < hdr.levelCount; ++l){
+        LevelRecord r;
+        std::memcpy(&r, base + sizeof(Header) + l * sizeof(LevelRecord), sizeof(r));
+        if (r.width == 0 || r.height == 0) return false;
+        if (r.size != levelBytes(format, int(r.width), int(r.height))) return false;
+        if (r.offset > size || r.size > size - r.offset) return false;
+
+        Level level;
+        level.width = int(r.width);
+        level.height = int(r.height);
+        level.data = reinterpret_cast<const uint8_t*>(base + r.offset);
+        level.size = size_t(r.size);
+        levels.push_back(level);
+    }
+
+    m_format = format;
+    m_srgb = (hdr.srgb != 0);
+    m_levels = std::move(levels);
+    return true;
+}
+
+std::vector<uint8_t> BakedTexture::decompress(int level) const
+{
+    const Level& lv = m_levels[level];
+    std::vector<uint8_t> out(size_t(lv.width) * lv.height * 4);
+    if (m_format == Format::RGBA8){
+        std::memcpy(out.data(), lv.data, out.size());
+        return out;
+    }
+
+    const int bw = (lv.width + 3) / 4, bh = (lv.height + 3) / 4;
+    const int bytes = blockBytes(m_format);
+    const uint8_t* in = lv.data;
+    uint8_t block[64];
+
+    for (int by = 0; by < bh; ++by){
+        for (int bx = 0; bx < bw; ++bx){
+            switch (m_format){
+            case Format::BC1: BlockCompression::decodeBC1(in, block); break;
+            case Format::BC3: BlockCompression::decodeBC3(in, block); break;
+            case Format::BC5: BlockCompression::decodeBC5(in, block); break;
+            case Format::RGBA8: break;
+            }
+            in += bytes;
+
+            // Пиксели дополнения за краем уровня отбрасываются
+            for (int j = 0; j < 4 && by * 4 + j < lv.height; ++j){
+                for (int i = 0; i < 4 && bx * 4 + i < lv.width; ++i){
+                    std::memcpy(&out[(size_t(by * 4 + j) * lv.width + bx * 4 + i) * 4], block + (j * 4 + i) * 4, 4);
+                }
+            }
+        }
+    }
+    return out;
+}
@@ -0,0 +1,71 @@
+#ifndef BAKEDTEXTURE_H
+#define BAKEDTEXTURE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include "mappedfile.h"
+
+// Назначение текстуры определяет формат запекания
+enum class TextureUsage
+{
+    Color,  // Цвет: BC1 для непрозрачных изображений, BC3 при наличии альфа-канала
+    Normal  // Карта нормалей: BC5 (X, Y), мип-уровни с перенормировкой
+};
+
+// Двоичный кеш запеченных текстур (.lhbt): изображение уже перевернуто по вертикали,
+// содержит полную цепочку мип-уровней и, как правило, сжато блоками S3TC/RGTC.
+// При первом обращении исходный PNG/JPG декодируется и запекается, далее уровни
+// передаются в GL прямо из отображенного в память файла.
+//
+// Раскладка файла (порядок байт платформы, уровни выровнены на 16 байт):
+//   Header | LevelRecord[levelCount] | данные уровней
+
+class BakedTexture
+{
+public:
+    enum class Format : quint32 { RGBA8, BC1, BC3, BC5 };
+
+    struct Level {
+        int width = 0;
+        int height = 0;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Кеш либо запекание исходного изображения; не использует GL,
+    // поэтому может выполняться в рабочем потоке
+    bool load(const QString& path, bool srgb, TextureUsage usage);
+    void close();
+
+    bool isNull() const { return m_levels.empty(); }
+    Format format() const { return m_format; }
+    bool srgb() const { return m_srgb; }
+    int width() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+    int height() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+    const std::vector<Level>& levels() const { return m_levels; }
+
+    bool isCompressed() const { return m_format != Format::RGBA8; }
+
+    // Распаковка уровня в RGBA8 (для GPU без поддержки сжатого формата)
+    std::vector<uint8_t> decompress(int level) const;
+
+private:
+    static QString cacheFilePath(const QString& key);
+    static QByteArray sourceHash(const QString& path, const QString& salt);
+
+    // Запекание изображения в m_blob (образ файла кеша)
+    bool bake(const QString& path, const QByteArray& hash, bool srgb, TextureUsage usage);
+    bool parse(const char* base, quint64 size, const QByteArray& expectedHash);
+
+    MappedFile m_file;   // Открытый кеш
+    QByteArray m_blob;   // Либо только что запеченные данные
+    Format m_format = Format::RGBA8;
+    bool m_srgb = false;
+    std::vector<Level> m_levels;
+};
+
+#endif // BAKEDTEXTURE_H
@@ -0,0 +1,224 @@
+#include "blockcompression.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+uint16_t pack565(const float c[3])
+{
+    auto q = [](float v, int maxv){ return int(std::lround(std::max(0.0f, std::min(255.0f, v)) * maxv / 255.0f)); };
+    return uint16_t((q(c[0], 31) << 11) | (q(c[1], 63) << 5) | q(c[2], 31));
+}
+
+void unpack565(uint16_t v, int out[3])
+{
+    const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+
+void write16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+uint16_t read16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+
+} // namespace
+
+void BlockCompression::encodeColor(const uint8_t rgba[64], uint8_t out[8])
+{
+    // Концы отрезка палитры - крайние проекции пикселей на главную ось цветов блока
+    float mean[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c) mean[c] += rgba[i * 4 + c];
+    for (float& m : mean) m /= 16.0f;
+
+    float cov[6] = {0, 0, 0, 0, 0, 0}; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; ++i){
+        const float r = rgba[i*4] - mean[0], g = rgba[i*4+1] - mean[1], b = rgba[i*4+2] - mean[2];
+        cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+        cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+    }
+
+    float axis[3] = {1, 1, 1};
+    for (int it = 0; it < 8; ++it){
+        const float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+        const float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+        const float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+        const float len = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (len < 1e-6f) break;
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+
+    float minT = 1e30f, maxT = -1e30f;
+    for (int i = 0; i < 16; ++i){
+        const float t = (rgba[i*4] - mean[0]) * axis[0] + (rgba[i*4+1] - mean[1]) * axis[1] + (rgba[i*4+2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    const float norm = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+    float lo[3], hi[3];
+    for (int c = 0; c < 3; ++c){
+        lo[c] = mean[c] + axis[c] * minT / std::max(norm, 1e-6f);
+        hi[c] = mean[c] + axis[c] * maxT / std::max(norm, 1e-6f);
+    }
+
+    uint16_t c0 = pack565(hi), c1 = pack565(lo);
+    if (c0 < c1) std::swap(c0, c1);
+
+    uint32_t bits = 0;
+    if (c0 != c1){
+        // Режим четырех цветов (c0 > c1): c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+        int e0[3], e1[3], pal[4][3];
+        unpack565(c0, e0);
+        unpack565(c1, e1);
+        for (int c = 0; c < 3; ++c){
+            pal[0][c] = e0[c];
+            pal[1][c] = e1[c];
+            pal[2][c] = (2 * e0[c] + e1[c]) / 3;
+            pal[3][c] = (e0[c] + 2 * e1[c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i){
+            int best = 0, bestDist = 1 << 30;
+            for (int k = 0; k < 4; ++k){
+                const int dr = rgba[i*4] - pal[k][0], dg = rgba[i*4+1] - pal[k][1], db = rgba[i*4+2] - pal[k][2];
+                const int d = dr*dr + dg*dg + db*db;
+                if (d < bestDist){ bestDist = d; best = k; }
+            }
+            bits |= uint32_t(best) << (i * 2);
+        }
+    }
+
+    write16(out, c0);
+    write16(out + 2, c1);
+    out[4] = uint8_t(bits);
+    out[5] = uint8_t(bits >> 8);
+    out[6] = uint8_t(bits >> 16);
+    out[7] = uint8_t(bits >> 24);
+}
+
+void BlockCompression::decodeColor(const uint8_t in[8], bool allowTransparent, uint8_t rgba[64])
+{
+    const uint16_t c0 = read16(in), c1 = read16(in + 2);
+    int e0[3], e1[3];
+    unpack565(c0, e0);
+    unpack565(c1, e1);
+
+    int pal[4][4];
+    for (int c = 0; c < 3; ++c){
+        pal[0][c] = e0[c];
+        pal[1][c] = e1[c];
+    }
+    pal[0][3] = pal[1][3] = pal[2][3] = pal[3][3] = 255;
+    if (c0 > c1 || !allowTransparent){
+        for (int c = 0; c < 3; ++c){
+            pal[2][c] = (2 * e0[c] + e1[c]) / 3;
+            pal[3][c] = (e0[c] + 2 * e1[c]) / 3;
+        }
+    } else {
+        // Режим трех цветов: середина отрезка и прозрачный черный
+        for (int c = 0; c < 3; ++c){
+            pal[2][c] = (e0[c] + e1[c]) / 2;
+            pal[3][c] = 0;
+        }
+        pal[3][3] = 0;
+    }
+
+    const uint32_t bits = uint32_t(in[4]) | (uint32_t(in[5]) << 8) | (uint32_t(in[6]) << 16) | (uint32_t(in[7]) << 24);
+    for (int i = 0; i < 16; ++i){
+        const int k = (bits >> (i * 2)) & 3;
+        for (int c = 0; c < 4; ++c) rgba[i*4 + c] = uint8_t(pal[k][c]);
+    }
+}
+
+void BlockCompression::encodeBC4(const uint8_t rgba[64], int channel, uint8_t out[8])
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i){
+        lo = std::min(lo, int(rgba[i*4 + channel]));
+        hi = std::max(hi, int(rgba[i*4 + channel]));
+    }
+
+    // Режим восьми значений (a0 > a1): a0, a1 и шесть промежуточных
+    out[0] = uint8_t(hi);
+    out[1] = uint8_t(lo);
+
+    uint64_t bits = 0;
+    if (hi != lo){
+        int pal[8];
+        pal[0] = hi;
+        pal[1] = lo;
+        for (int k = 1; k <= 6; ++k) pal[k + 1] = ((7 - k) * hi + k * lo) / 7;
+        for (int i = 0; i < 16; ++i){
+            const int v = rgba[i*4 + channel];
+            int best = 0, bestDist = 1 << 30;
+            for (int k = 0; k < 8; ++k){
+                const int d = std::abs(v - pal[k]);
+                if (d < bestDist){ bestDist = d; best = k; }
+            }
+            bits |= uint64_t(best) << (i * 3);
+        }
+    }
+    for (int b = 0; b < 6; ++b) out[2 + b] = uint8_t(bits >> (b * 8));
+}
+
+void BlockCompression::decodeBC4(const uint8_t in[8], int channel, uint8_t rgba[64])
+{
+    const int a0 = in[0], a1 = in[1];
+    int pal[8];
+    pal[0] = a0;
+    pal[1] = a1;
+    if (a0 > a1){
+        for (int k = 1; k <= 6; ++k) pal[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+    } else {
+        for (int k = 1; k <= 4; ++k) pal[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+
+    uint64_t bits = 0;
+    for (int b = 0; b < 6; ++b) bits |= uint64_t(in[2 + b]) << (b * 8);
+    for (int i = 0; i < 16; ++i) rgba[i*4 + channel] = uint8_t(pal[(bits >> (i * 3)) & 7]);
+}
+
+void BlockCompression::encodeBC1(const uint8_t rgba[64], uint8_t out[8])
+{
+    encodeColor(rgba, out);
+}
+
+void BlockCompression::encodeBC3(const uint8_t rgba[64], uint8_t out[16])
+{
+    encodeBC4(rgba, 3, out);
+    encodeColor(rgba, out + 8);
+}
+
+void BlockCompression::encodeBC5(const uint8_t rgba[64], uint8_t out[16])
+{
+    encodeBC4(rgba, 0, out);
+    encodeBC4(rgba, 1, out + 8);
+}
+
+void BlockCompression::decodeBC1(const uint8_t in[8], uint8_t rgba[64])
+{
+    decodeColor(in, true, rgba);
+}
+
+void BlockCompression::decodeBC3(const uint8_t in[16], uint8_t rgba[64])
+{
+    decodeColor(in + 8, false, rgba);
+    decodeBC4(in, 3, rgba);
+}
+
+void BlockCompression::decodeBC5(const uint8_t in[16], uint8_t rgba[64])
+{
+    decodeBC4(in, 0, rgba);
+    decodeBC4(in + 8, 1, rgba);
+
+    // Z нормали восстанавливается из X и Y (как в шейдере)
+    for (int i = 0; i < 16; ++i){
+        const float x = rgba[i*4] / 127.5f - 1.0f;
+        const float y = rgba[i*4 + 1] / 127.5f - 1.0f;
+        const float z = std::sqrt(std::max(0.0f, 1.0f - x*x - y*y));
+        rgba[i*4 + 2] = uint8_t(std::lround((z * 0.5f + 0.5f) * 255.0f));
+        rgba[i*4 + 3] = 255;
+    }
+}
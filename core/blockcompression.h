@@ -0,0 +1,33 @@
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+
+#include <cstdint>
+
+// Блочное сжатие текстур (S3TC/RGTC): кодирование и декодирование блоков 4x4.
+// Блок на входе кодера и выходе декодера - 16 пикселей RGBA8 построчно.
+//   BC1 - цвет без прозрачности, 8 байт на блок;
+//   BC3 - цвет (как BC1) + отдельный канал альфа, 16 байт;
+//   BC5 - два независимых канала (R, G), 16 байт - для карт нормалей.
+
+class BlockCompression
+{
+public:
+    static void encodeBC1(const uint8_t rgba[64], uint8_t out[8]);
+    static void encodeBC3(const uint8_t rgba[64], uint8_t out[16]);
+    static void encodeBC5(const uint8_t rgba[64], uint8_t out[16]);
+
+    static void decodeBC1(const uint8_t in[8], uint8_t rgba[64]);
+    static void decodeBC3(const uint8_t in[16], uint8_t rgba[64]);
+    static void decodeBC5(const uint8_t in[16], uint8_t rgba[64]);
+
+private:
+    // Одноканальный блок BC4 (channel - смещение канала в пикселе RGBA)
+    static void encodeBC4(const uint8_t rgba[64], int channel, uint8_t out[8]);
+    static void decodeBC4(const uint8_t in[8], int channel, uint8_t rgba[64]);
+
+    // Цветовая часть BC1/BC3
+    static void encodeColor(const uint8_t rgba[64], uint8_t out[8]);
+    static void decodeColor(const uint8_t in[8], bool allowTransparent, uint8_t rgba[64]);
+};
+
+#endif // BLOCKCOMPRESSION_H
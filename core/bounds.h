@@ -0,0 +1,124 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+#include "math3d.h"
+
+// Ограничивающие объемы: параллелепипед по осям (AABB) и описанная сфера.
+// Пустые границы (ни одной точки) имеют min > max и нулевой радиус
+
+struct Bounds
+{
+    Vec3 min{ std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max()};
+    Vec3 max{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+    Vec3 center{0.0f, 0.0f, 0.0f}; // Центр сферы
+    float radius = 0.0f;
+
+    bool isEmpty() const { return min.x > max.x; }
+
+    Vec3 boxCenter() const { return (min + max) * 0.5f; }
+    Vec3 extents() const { return (max - min) * 0.5f; }
+
+    // Границы точек items[k].pos: центр сферы - центр AABB, радиус - до самой дальней точки
+    template <typename T>
+    static Bounds fromPositions(const T* items, size_t count)
+    {
+        Bounds b;
+        if (count == 0) return b;
+        for (size_t k = 0; k < count; ++k){
+            const Vec3& p = items[k].pos;
+            b.min = {std::min(b.min.x, p.x), std::min(b.min.y, p.y), std::min(b.min.z, p.z)};
+            b.max = {std::max(b.max.x, p.x), std::max(b.max.y, p.y), std::max(b.max.z, p.z)};
+        }
+        b.center = b.boxCenter();
+        float r2 = 0.0f;
+        for (size_t k = 0; k < count; ++k){
+            const Vec3 d = items[k].pos - b.center;
+            r2 = std::max(r2, dot(d, d));
+        }
+        b.radius = std::sqrt(r2);
+        return b;
+    }
+
+    // Объединение: AABB - покомпонентно, сфера - наименьшая, содержащая обе сферы
+    void merge(const Bounds& o)
+    {
+        if (o.isEmpty()) return;
+        if (isEmpty()){ *this = o; return; }
+
+        min = {std::min(min.x, o.min.x), std::min(min.y, o.min.y), std::min(min.z, o.min.z)};
+        max = {std::max(max.x, o.max.x), std::max(max.y, o.max.y), std::max(max.z, o.max.z)};
+
+        const Vec3 d = o.center - center;
+        const float dist = length(d);
+        if (dist + o.radius <= radius) return;
+        if (dist + radius <= o.radius){ center = o.center; radius = o.radius; return; }
+        const float r = 0.5f * (dist + radius + o.radius);
+        center = center + d * ((r - radius) / dist);
+        radius = r;
+    }
+
+    // Границы после преобразования: AABB описывает преобразованный параллелепипед,
+    // радиус сферы растет на наибольший масштаб по осям
+    Bounds transformed(const Mat4& m) const
+    {
+        if (isEmpty()) return *this;
+
+        const Vec3 c = transformPoint(m, boxCenter());
+        const Vec3 e = extents();
+        const auto& a = m.m;
+        const Vec3 te{
+            std::abs(a[0])*e.x + std::abs(a[4])*e.y + std::abs(a[8])*e.z,
+            std::abs(a[1])*e.x + std::abs(a[5])*e.y + std::abs(a[9])*e.z,
+            std::abs(a[2])*e.x + std::abs(a[6])*e.y + std::abs(a[10])*e.z
+        };
+
+        const float sx = a[0]*a[0] + a[1]*a[1] + a[2]*a[2];
+        const float sy = a[4]*a[4] + a[5]*a[5] + a[6]*a[6];
+        const float sz = a[8]*a[8] + a[9]*a[9] + a[10]*a[10];
+
+        Bounds r;
+        r.min = c - te;
+        r.max = c + te;
+        r.center = transformPoint(m, center);
+        r.radius = radius * std::sqrt(std::max(sx, std::max(sy, sz)));
+        return r;
+    }
+};
+
+// Пересечение луча origin + t * dir (invDir = 1 / dir) с AABB при t в [0, maxT]
+// методом пластин; tEntry - вход луча в параллелепипед
+inline bool rayBoxEntry(const Vec3& min, const Vec3& max, const Vec3& origin, const Vec3& invDir,
+                        float maxT, float& tEntry)
+{
+    float t0 = 0.0f, t1 = maxT;
+    const float o[3]  = {origin.x, origin.y, origin.z};
+    const float id[3] = {invDir.x, invDir.y, invDir.z};
+    const float lo[3] = {min.x, min.y, min.z};
+    const float hi[3] = {max.x, max.y, max.z};
+    for (int a = 0; a < 3; ++a){
+        float tn = (lo[a] - o[a]) * id[a];
+        float tf = (hi[a] - o[a]) * id[a];
+        if (tn > tf) std::swap(tn, tf);
+        t0 = std::max(t0, tn);
+        t1 = std::min(t1, tf);
+        if (t0 > t1) return false;
+    }
+    tEntry = t0;
+    return true;
+}
+
+// Обратные компоненты направления луча (нулевая компонента - без деления на ноль)
+inline Vec3 rayInverse(const Vec3& dir)
+{
+    auto inv = [](float v){ return (v != 0.0f) ? 1.0f / v : std::numeric_limits<float>::max(); };
+    return {inv(dir.x), inv(dir.y), inv(dir.z)};
+}
+
+#endif // BOUNDS_H
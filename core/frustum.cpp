@@ -0,0 +1,143 @@
+#include "frustum.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2 1
+#endif
+
+namespace {
+
+// Полуразмер, заведомо охватывающий всю сцену
+const float kUnboundedExtent = 1e30f;
+
+} // namespace
+
+void PackedBounds::clear()
+{
+    m_count = 0;
+    m_cx.clear(); m_cy.clear(); m_cz.clear();
+    m_ex.clear(); m_ey.clear(); m_ez.clear();
+}
+
+int PackedBounds::add(const Bounds& b)
+{
+    // Дополнение до кратного 4: хвост пачки заполняется нулевыми границами
+    if ((m_count & 3) == 0){
+        const size_t padded = size_t(m_count) + 4;
+        for (auto* v : {&m_cx, &m_cy, &m_cz, &m_ex, &m_ey, &m_ez}) v->resize(padded, 0.0f);
+    }
+
+    const int k = m_count++;
+    if (b.isEmpty()){
+        m_ex[k] = m_ey[k] = m_ez[k] = kUnboundedExtent;
+        return k;
+    }
+    const Vec3 c = b.boxCenter();
+    const Vec3 e = b.extents();
+    m_cx[k] = c.x; m_cy[k] = c.y; m_cz[k] = c.z;
+    m_ex[k] = e.x; m_ey[k] = e.y; m_ez[k] = e.z;
+    return k;
+}
+
+void Frustum::setMatrix(const Mat4& viewProj)
+{
+    // Строки матрицы (хранение по столбцам): плоскости - w +- x, w +- y, w +- z
+    const auto& a = viewProj.m;
+    auto row = [&](int r, int c){ return a[c*4 + r]; };
+
+    for (int p = 0; p < 6; ++p){
+        const int axis = p / 2;
+        const float sign = (p & 1) ? -1.0f : 1.0f;
+        float len2 = 0.0f;
+        for (int c = 0; c < 4; ++c){
+            m_planes[p][c] = row(3, c) + sign * row(axis, c);
+            if (c < 3) len2 += m_planes[p][c] * m_planes[p][c];
+        }
+        const float inv = (len2 > 0.0f) ? 1.0f / std::sqrt(len2) : 0.0f;
+        for (float& v : m_planes[p]) v *= inv;
+    }
+}
+
+bool Frustum::intersects(const Bounds& b) const
+{
+    if (b.isEmpty()) return true;
+
+    // AABB вне пирамиды, если она целиком за одной из плоскостей
+    const Vec3 c = b.boxCenter();
+    const Vec3 e = b.extents();
+    for (const auto& p : m_planes){
+        const float d = p[0]*c.x + p[1]*c.y + p[2]*c.z + p[3]
+                      + std::abs(p[0])*e.x + std::abs(p[1])*e.y + std::abs(p[2])*e.z;
+        if (d < 0.0f) return false;
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classify(const Vec3& min, const Vec3& max) const
+{
+    const Vec3 c = (min + max) * 0.5f;
+    const Vec3 e = (max - min) * 0.5f;
+    Containment result = Containment::Inside;
+    for (const auto& p : m_planes){
+        const float d = p[0]*c.x + p[1]*c.y + p[2]*c.z + p[3];
+        const float r = std::abs(p[0])*e.x + std::abs(p[1])*e.y + std::abs(p[2])*e.z;
+        if (d + r < 0.0f) return Containment::Outside;
+        if (d - r < 0.0f) result = Containment::Intersects;
+    }
+    return result;
+}
+
+void Frustum::cull(const PackedBounds& bounds, std::vector<uint8_t>& visible) const
+{
+    const int count = bounds.size();
+    visible.resize(size_t(count + 3) & ~size_t(3));
+
+#ifdef FRUSTUM_SSE2
+    __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; ++p){
+        px[p] = _mm_set1_ps(m_planes[p][0]);
+        py[p] = _mm_set1_ps(m_planes[p][1]);
+        pz[p] = _mm_set1_ps(m_planes[p][2]);
+        pw[p] = _mm_set1_ps(m_planes[p][3]);
+        ax[p] = _mm_set1_ps(std::abs(m_planes[p][0]));
+        ay[p] = _mm_set1_ps(std::abs(m_planes[p][1]));
+        az[p] = _mm_set1_ps(std::abs(m_planes[p][2]));
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    for (int k = 0; k < count; k += 4){
+        const __m128 cx = _mm_loadu_ps(&bounds.m_cx[k]);
+        const __m128 cy = _mm_loadu_ps(&bounds.m_cy[k]);
+        const __m128 cz = _mm_loadu_ps(&bounds.m_cz[k]);
+        const __m128 ex = _mm_loadu_ps(&bounds.m_ex[k]);
+        const __m128 ey = _mm_loadu_ps(&bounds.m_ey[k]);
+        const __m128 ez = _mm_loadu_ps(&bounds.m_ez[k]);
+
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (int p = 0; p < 6; ++p){
+            __m128 d = _mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy));
+            d = _mm_add_ps(d, _mm_mul_ps(pz[p], cz));
+            d = _mm_add_ps(d, pw[p]);
+            d = _mm_add_ps(d, _mm_mul_ps(ax[p], ex));
+            d = _mm_add_ps(d, _mm_mul_ps(ay[p], ey));
+            d = _mm_add_ps(d, _mm_mul_ps(az[p], ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (int j = 0; j < 4; ++j) visible[k + j] = uint8_t((mask >> j) & 1);
+    }
+#else
+    for (int k = 0; k < count; ++k){
+        bool inside = true;
+        for (const auto& p : m_planes){
+            const float d = p[0]*bounds.m_cx[k] + p[1]*bounds.m_cy[k] + p[2]*bounds.m_cz[k] + p[3]
+                          + std::abs(p[0])*bounds.m_ex[k] + std::abs(p[1])*bounds.m_ey[k] + std::abs(p[2])*bounds.m_ez[k];
+            if (d < 0.0f){ inside = false; break; }
+        }
+        visible[k] = inside ? 1 : 0;
+    }
+#endif
+}
@@ -0,0 +1,50 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bounds.h"
+
+// Границы объектов кадра в раскладке SoA (центр и полуразмеры AABB по отдельным массивам),
+// удобной для проверки нескольких объектов одной SIMD-инструкцией.
+// Массивы дополняются до кратного 4 размера
+class PackedBounds
+{
+public:
+    void clear();
+
+    // Пустые границы (модель еще не загружена) не отсекаются
+    int add(const Bounds& b);
+
+    int size() const { return m_count; }
+
+private:
+    friend class Frustum;
+
+    int m_count = 0;
+    std::vector<float> m_cx, m_cy, m_cz;
+    std::vector<float> m_ex, m_ey, m_ez;
+};
+
+// Пирамида видимости: шесть плоскостей, извлеченных из матрицы proj * view
+// (нормали направлены внутрь)
+class Frustum
+{
+public:
+    enum class Containment { Outside, Intersects, Inside };
+
+    void setMatrix(const Mat4& viewProj);
+
+    bool intersects(const Bounds& b) const;
+    // Положение AABB относительно пирамиды (для иерархического обхода)
+    Containment classify(const Vec3& min, const Vec3& max) const;
+
+    // visible[k] = 1, если AABB k пересекает пирамиду (проверка по 4 объекта на SSE2)
+    void cull(const PackedBounds& bounds, std::vector<uint8_t>& visible) const;
+
+private:
+    float m_planes[6][4] = {};
+};
+
+#endif // FRUSTUM_H
@@ -0,0 +1,164 @@
+#include "geometryarena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "glstate.h"
+#include "mesh.h"
+
+namespace {
+
+// Смещение индексов в EBO кратно размеру 32-битного индекса
+const size_t kIndexAlignment = 4;
+
+size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+} // namespace
+
+void GeometryArena::FreeList::reset(size_t capacity)
+{
+    m_free.clear();
+    if (capacity > 0) m_free.emplace(0, capacity);
+}
+
+size_t GeometryArena::FreeList::allocate(size_t size, size_t alignment)
+{
+    // Первый подходящий диапазон: остатки до и после выделенного участка остаются свободными
+    for (auto it = m_free.begin(); it != m_free.end(); ++it){
+        const size_t start = it->first;
+        const size_t end = start + it->second;
+        const size_t offset = alignUp(start, alignment);
+        if (offset > end || end - offset < size) continue;
+
+        m_free.erase(it);
+        if (offset > start) m_free.emplace(start, offset - start);
+        if (end > offset + size) m_free.emplace(offset + size, end - offset - size);
+        return offset;
+    }
+    return npos;
+}
+
+void GeometryArena::FreeList::free(size_t offset, size_t size)
+{
+    if (size == 0) return;
+    auto it = m_free.emplace(offset, size).first;
+
+    auto next = std::next(it);
+    if (next != m_free.end() && it->first + it->second == next->first){
+        it->second += next->second;
+        m_free.erase(next);
+    }
+    if (it != m_free.begin()){
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first){
+            prev->second += it->second;
+            m_free.erase(it);
+        }
+    }
+}
+
+GeometryArena& GeometryArena::instance()
+{
+    static GeometryArena arena;
+    return arena;
+}
+
+int GeometryArena::createPool(QOpenGLFunctions_3_3_Core* f, const VertexFormat& format, size_t vertexCapacity, size_t indexCapacity)
+{
+    Pool pool;
+    pool.format = &format;
+    pool.vertices.reset(vertexCapacity);
+    pool.indices.reset(indexCapacity);
+
+    f->glGenVertexArrays(1, &pool.vao);
+    f->glGenBuffers(1, &pool.vbo);
+    f->glGenBuffers(1, &pool.ebo);
+
+    GLState::instance().bindVertexArray(f, pool.vao);
+
+    f->glBindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+    f->glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(vertexCapacity * format.stride), nullptr, GL_STATIC_DRAW);
+    for (const auto& a : format.attribs){
+        f->glEnableVertexAttribArray(a.location);
+        f->glVertexAttribPointer(a.location, a.components, a.type, a.normalized ? GL_TRUE : GL_FALSE,
+                                 format.stride, (void*)(uintptr_t)a.offset);
+    }
+
+    // Индексный буфер входит в состояние VAO
+    f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ebo);
+    f->glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity, nullptr, GL_STATIC_DRAW);
+
+    GLState::instance().bindVertexArray(f, 0);
+
+    m_pools.push_back(std::move(pool));
+    return (int)m_pools.size() - 1;
+}
+
+GeometryArena::Allocation GeometryArena::upload(QOpenGLFunctions_3_3_Core* f, const VertexFormat& format,
+                                                const void* vertices, size_t vertexCount, const void* indices, size_t indexBytes)
+{
+    Allocation a;
+    if (vertexCount == 0 || indexBytes == 0) return a;
+
+    auto tryPool = [&](int k){
+        Pool& p = m_pools[k];
+        const size_t v = p.vertices.allocate(vertexCount, 1);
+        if (v == FreeList::npos) return false;
+        const size_t i = p.indices.allocate(indexBytes, kIndexAlignment);
+        if (i == FreeList::npos){
+            p.vertices.free(v, vertexCount);
+            return false;
+        }
+        a.pool = k;
+        a.firstVertex = v;
+        a.indexOffset = i;
+        return true;
+    };
+
+    for (int k = 0; k < (int)m_pools.size() && !a.isValid(); ++k){
+        if (m_pools[k].format == &format) tryPool(k);
+    }
+    if (!a.isValid()){
+        const size_t vertexCapacity = std::max(kPoolVertexBytes / format.stride, vertexCount);
+        const size_t indexCapacity = std::max(kPoolIndexBytes, alignUp(indexBytes, kIndexAlignment));
+        tryPool(createPool(f, format, vertexCapacity, indexCapacity));
+    }
+    a.vertexCount = vertexCount;
+    a.indexBytes = indexBytes;
+
+    // Запись через GL_COPY_WRITE_BUFFER не затрагивает привязки VAO
+    const Pool& p = m_pools[a.pool];
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, p.vbo);
+    f->glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)(a.firstVertex * format.stride),
+                       (GLsizeiptr)(vertexCount * format.stride), vertices);
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, p.ebo);
+    f->glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)a.indexOffset, (GLsizeiptr)indexBytes, indices);
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return a;
+}
+
+void GeometryArena::free(const Allocation& a)
+{
+    if (!a.isValid() || a.pool >= (int)m_pools.size()) return;
+    Pool& p = m_pools[a.pool];
+    p.vertices.free(a.firstVertex, a.vertexCount);
+    p.indices.free(a.indexOffset, a.indexBytes);
+}
+
+void GeometryArena::bind(QOpenGLFunctions_3_3_Core* f, const Allocation& a) const
+{
+    GLState::instance().bindVertexArray(f, m_pools[a.pool].vao);
+}
+
+void GeometryArena::release(QOpenGLFunctions_3_3_Core* f)
+{
+    for (auto& p : m_pools){
+        GLState::instance().forgetVertexArray(p.vao);
+        f->glDeleteVertexArrays(1, &p.vao);
+        f->glDeleteBuffers(1, &p.vbo);
+        f->glDeleteBuffers(1, &p.ebo);
+    }
+    m_pools.clear();
+}
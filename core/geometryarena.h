@@ -0,0 +1,80 @@
+#ifndef GEOMETRYARENA_H
+#define GEOMETRYARENA_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+class QOpenGLFunctions_3_3_Core;
+struct VertexFormat;
+
+// Общее хранилище статической геометрии: вершины и индексы всех сеток
+// размещаются в нескольких больших парах VBO/EBO, по одному VAO на пул.
+// Пулы заводятся отдельно для каждого формата вершин; сетка - это диапазон пула,
+// который рисуется glDrawElementsBaseVertex (индексы остаются локальными для сетки).
+// Освобожденные диапазоны возвращаются в список свободных и сливаются с соседними
+
+class GeometryArena
+{
+public:
+    struct Allocation
+    {
+        int pool = -1;
+        size_t firstVertex = 0;  // baseVertex для glDrawElementsBaseVertex
+        size_t vertexCount = 0;
+        size_t indexOffset = 0;  // Смещение в EBO пула (байты)
+        size_t indexBytes = 0;
+
+        bool isValid() const { return pool >= 0; }
+    };
+
+    // Объем одного пула; сетка, которая в него не помещается, получает пул своего размера
+    static constexpr size_t kPoolVertexBytes = 16u << 20;
+    static constexpr size_t kPoolIndexBytes  = 8u << 20;
+
+    static GeometryArena& instance();
+
+    // Размещение и запись данных (вершины уже в раскладке format)
+    Allocation upload(QOpenGLFunctions_3_3_Core* f, const VertexFormat& format,
+                      const void* vertices, size_t vertexCount, const void* indices, size_t indexBytes);
+    void free(const Allocation& a);
+
+    // Привязка VAO пула, в котором лежит диапазон
+    void bind(QOpenGLFunctions_3_3_Core* f, const Allocation& a) const;
+
+    // Удаление всех пулов (нужен текущий GL-контекст)
+    void release(QOpenGLFunctions_3_3_Core* f);
+
+    int poolCount() const { return (int)m_pools.size(); }
+
+private:
+    GeometryArena() = default;
+
+    // Список свободных диапазонов: начало -> длина, соседние диапазоны сливаются
+    class FreeList
+    {
+    public:
+        static constexpr size_t npos = ~size_t(0);
+
+        void reset(size_t capacity);
+        size_t allocate(size_t size, size_t alignment);
+        void free(size_t offset, size_t size);
+
+    private:
+        std::map<size_t, size_t> m_free;
+    };
+
+    struct Pool
+    {
+        const VertexFormat* format = nullptr;
+        unsigned vao = 0, vbo = 0, ebo = 0;
+        FreeList vertices; // В вершинах
+        FreeList indices;  // В байтах
+    };
+
+    int createPool(QOpenGLFunctions_3_3_Core* f, const VertexFormat& format, size_t vertexCapacity, size_t indexCapacity);
+
+    std::vector<Pool> m_pools;
+};
+
+#endif // GEOMETRYARENA_H
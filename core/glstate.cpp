@@ -0,0 +1,76 @@
+#include "glstate.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+
+GLState& GLState::instance()
+{
+    static GLState state;
+    return state;
+}
+
+void GLState::useProgram(QOpenGLFunctions_3_3_Core* f, unsigned program)
+{
+    if (m_program == program) return;
+    f->glUseProgram(program);
+    m_program = program;
+}
+
+void GLState::bindVertexArray(QOpenGLFunctions_3_3_Core* f, unsigned vao)
+{
+    if (m_vao == vao) return;
+    f->glBindVertexArray(vao);
+    m_vao = vao;
+}
+
+void GLState::bindTexture(QOpenGLFunctions_3_3_Core* f, int unit, unsigned texture)
+{
+    const bool tracked = (unit >= 0 && unit < kMaxTextureUnits);
+    if (tracked && m_textures[unit] == texture) return;
+
+    if (m_activeUnit != unit){
+        f->glActiveTexture(GL_TEXTURE0 + unit);
+        m_activeUnit = unit;
+    }
+    f->glBindTexture(GL_TEXTURE_2D, texture);
+    if (tracked) m_textures[unit] = texture;
+}
+
+void GLState::vertexAttrib3f(QOpenGLFunctions_3_3_Core* f, unsigned index, float x, float y, float z)
+{
+    if (index < unsigned(kMaxVertexAttribs)){
+        Attrib& a = m_attribs[index];
+        if (a.known && a.v[0] == x && a.v[1] == y && a.v[2] == z) return;
+        a.known = true;
+        a.v[0] = x; a.v[1] = y; a.v[2] = z;
+    }
+    f->glVertexAttrib3f(index, x, y, z);
+}
+
+void GLState::forgetProgram(unsigned program)
+{
+    // Удаление текущей программы откладывается GL до ее смены, привязка остается
+    if (m_program == program) m_program = kUnknown;
+}
+
+void GLState::forgetVertexArray(unsigned vao)
+{
+    if (m_vao == vao) m_vao = 0;
+}
+
+void GLState::forgetTextures(const unsigned* textures, int count)
+{
+    for (int k = 0; k < count; ++k){
+        for (unsigned& bound : m_textures){
+            if (bound == textures[k]) bound = 0;
+        }
+    }
+}
+
+void GLState::invalidate()
+{
+    m_program = kUnknown;
+    m_vao = kUnknown;
+    m_activeUnit = -1;
+    for (unsigned& t : m_textures) t = kUnknown;
+    for (Attrib& a : m_attribs) a.known = false;
+}
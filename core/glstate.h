@@ -0,0 +1,52 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+class QOpenGLFunctions_3_3_Core;
+
+// Кеш состояния GL: повторная установка текущей программы, VAO, текстуры блока
+// или постоянного значения атрибута не доходит до драйвера.
+// Весь код сцены меняет это состояние только через GLState; после кода, который
+// может изменить его в обход (Qt между кадрами), вызывается invalidate().
+// Удаленные объекты GL отвязывает сам, поэтому кеш о них нужно уведомлять (forget*)
+
+class GLState
+{
+public:
+    static constexpr int kMaxTextureUnits = 16;
+    static constexpr int kMaxVertexAttribs = 8;
+
+    static GLState& instance();
+
+    void useProgram(QOpenGLFunctions_3_3_Core* f, unsigned program);
+    void bindVertexArray(QOpenGLFunctions_3_3_Core* f, unsigned vao);
+    void bindTexture(QOpenGLFunctions_3_3_Core* f, int unit, unsigned texture); // GL_TEXTURE_2D
+    void vertexAttrib3f(QOpenGLFunctions_3_3_Core* f, unsigned index, float x, float y, float z);
+
+    unsigned program() const { return m_program; }
+
+    void forgetProgram(unsigned program);
+    void forgetVertexArray(unsigned vao);
+    void forgetTextures(const unsigned* textures, int count);
+
+    // Состояние неизвестно: следующая установка каждого параметра дойдет до GL
+    void invalidate();
+
+private:
+    GLState() { invalidate(); }
+
+    static constexpr unsigned kUnknown = ~0u;
+
+    unsigned m_program;
+    unsigned m_vao;
+    int m_activeUnit;
+    unsigned m_textures[kMaxTextureUnits];
+
+    struct Attrib
+    {
+        bool known;
+        float v[3];
+    };
+    Attrib m_attribs[kMaxVertexAttribs];
+};
+
+#endif // GLSTATE_H
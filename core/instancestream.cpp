@@ -0,0 +1,73 @@
+#include "instancestream.h"
+
+#include <cstdint>
+
+#include <QDebug>
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "mesh.h"
+
+void InstanceStream::init(QOpenGLFunctions_3_3_Core* f, size_t capacity)
+{
+    if (!m_vbo) f->glGenBuffers(1, &m_vbo);
+    m_capacity = capacity;
+    m_head = 0;
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    f->glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity, nullptr, GL_STREAM_DRAW);
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void InstanceStream::release(QOpenGLFunctions_3_3_Core* f)
+{
+    if (m_vbo) f->glDeleteBuffers(1, &m_vbo);
+    m_vbo = 0;
+    m_capacity = m_head = 0;
+}
+
+InstanceBatch InstanceStream::push(QOpenGLFunctions_3_3_Core* f, const InstanceData* data, int count)
+{
+    InstanceBatch batch;
+    const size_t size = size_t(count) * sizeof(InstanceData);
+    if (count <= 0 || !m_vbo) return batch;
+
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    size_t offset = m_head;
+    if (size > m_capacity){
+        // Блок кадра не помещается целиком: буфер растет до ближайшей степени двойки
+        size_t capacity = m_capacity ? m_capacity : sizeof(InstanceData);
+        while (capacity < size) capacity *= 2;
+        qWarning() << "InstanceStream: growing from" << m_capacity << "to" << capacity << "bytes for" << count << "instances";
+        m_capacity = capacity;
+        f->glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_capacity, nullptr, GL_STREAM_DRAW);
+        offset = 0;
+    } else if (offset + size > m_capacity){
+        // Старое хранилище остается у GPU до завершения использующих его команд
+        f->glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_capacity, nullptr, GL_STREAM_DRAW);
+        offset = 0;
+    }
+    f->glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    f->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_head = offset + size;
+
+    batch.buffer = m_vbo;
+    batch.offset = offset;
+    batch.count = count;
+    return batch;
+}
+
+void InstanceBatch::bindAttribs(QOpenGLFunctions_3_3_Core* f) const
+{
+    // Указатели атрибутов запоминают буфер, привязанный к GL_ARRAY_BUFFER в момент вызова
+    f->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (unsigned column = 0; column < 4; ++column){
+        const unsigned location = AttribInstanceModel + column;
+        f->glEnableVertexAttribArray(location);
+        f->glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                 (void*)(uintptr_t)(offset + offsetof(InstanceData, model) + column * 4 * sizeof(float)));
+        f->glVertexAttribDivisor(location, 1);
+    }
+    f->glEnableVertexAttribArray(AttribInstanceTint);
+    f->glVertexAttribPointer(AttribInstanceTint, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                             (void*)(uintptr_t)(offset + offsetof(InstanceData, tint)));
+    f->glVertexAttribDivisor(AttribInstanceTint, 1);
+}
@@ -0,0 +1,54 @@
+#ifndef INSTANCESTREAM_H
+#define INSTANCESTREAM_H
+
+#include <cstddef>
+
+class QOpenGLFunctions_3_3_Core;
+
+// Параметры одного экземпляра при инстансинге: матрица модели (по столбцам)
+// и цветовой множитель. В шейдере - атрибуты AttribInstanceModel (mat4, 4 слота)
+// и AttribInstanceTint с делителем 1
+struct InstanceData
+{
+    float model[16];
+    float tint[3];
+    float pad;
+};
+static_assert(sizeof(InstanceData) == 80, "InstanceData layout is mirrored by the instance attributes");
+
+// Диапазон экземпляров в буфере InstanceStream
+struct InstanceBatch
+{
+    unsigned buffer = 0;
+    size_t offset = 0; // Байты от начала буфера
+    int count = 0;
+
+    // Диапазон из n экземпляров, начиная с first
+    InstanceBatch sub(int first, int n) const { return {buffer, offset + size_t(first) * sizeof(InstanceData), n}; }
+
+    // Подключение атрибутов экземпляров к привязанному VAO. Атрибуты указывают на диапазон
+    // и переустанавливаются перед каждым вызовом, потому что базовый экземпляр в GL 3.3 задать нельзя
+    void bindAttribs(QOpenGLFunctions_3_3_Core* f) const;
+};
+
+// Потоковый буфер параметров экземпляров: данные кадра дописываются за предыдущими,
+// при переполнении хранилище заменяется новым (orphaning), как в UniformRing.
+// Блок больше всего буфера увеличивает его, а не отбрасывается
+
+class InstanceStream
+{
+public:
+    void init(QOpenGLFunctions_3_3_Core* f, size_t capacity);
+    void release(QOpenGLFunctions_3_3_Core* f);
+
+    InstanceBatch push(QOpenGLFunctions_3_3_Core* f, const InstanceData* data, int count);
+
+    bool isValid() const { return m_vbo != 0; }
+
+private:
+    unsigned m_vbo = 0;
+    size_t m_capacity = 0;
+    size_t m_head = 0;
+};
+
+#endif // INSTANCESTREAM_H
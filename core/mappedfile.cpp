@@ -0,0 +1,54 @@
+#include "mappedfile.h"
+
+#include <QResource>
+
+bool MappedFile::open(const QString& path)
+{
+    close();
+
+    if (path.startsWith(":/")){
+        QResource res(path);
+        if (!res.isValid()) return false;
+
+        if (res.compressionAlgorithm() == QResource::NoCompression){
+            // Данные ресурса лежат в памяти процесса все время работы приложения
+            m_data = reinterpret_cast<const char*>(res.data());
+            m_size = res.size();
+        } else {
+            m_copy = res.uncompressedData();
+            m_data = m_copy.constData();
+            m_size = m_copy.size();
+        }
+        m_open = true;
+        return true;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) return false;
+
+    m_size = m_file.size();
+    if (m_size > 0) m_mapped = m_file.map(0, m_size);
+
+    if (m_mapped){
+        m_data = reinterpret_cast<const char*>(m_mapped);
+    } else {
+        m_copy = m_file.readAll();
+        m_data = m_copy.constData();
+        m_size = m_copy.size();
+    }
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_mapped){
+        m_file.unmap(m_mapped);
+        m_mapped = nullptr;
+    }
+    if (m_file.isOpen()) m_file.close();
+    m_copy = QByteArray();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
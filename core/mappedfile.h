@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Доступ к содержимому файла только для чтения без построчного копирования:
+// - несжатые ресурсы Qt (:/...) читаются напрямую из памяти приложения;
+// - обычные файлы отображаются в память (mmap);
+// - в остальных случаях (сжатый ресурс, отказ mmap) файл читается целиком один раз
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const QString& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const QString& path);
+    void close();
+
+    bool isOpen() const { return m_open; }
+    const char* data() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    qint64 size() const { return m_size; }
+
+private:
+    QFile m_file;
+    uchar* m_mapped = nullptr;
+    QByteArray m_copy;
+
+    const char* m_data = nullptr;
+    qint64 m_size = 0;
+    bool m_open = false;
+};
+
+#endif // MAPPEDFILE_H
@@ -1,34 +1,217 @@
 #include "mesh.h"
 
-void Mesh::upload(QOpenGLFunctions_3_3_Core* f, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices)
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "glstate.h"
+
+namespace {
+
+struct QuantizedVertex
+{
+    uint16_t pos[4];  // x, y, z и выравнивание
+    uint32_t nrm;     // 2_10_10_10_REV
+    uint16_t uv[2];   // half float
+};
+
+static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must be 16 bytes");
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const int32_t exp = int32_t((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mant = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFFu) == 0xFFu) return uint16_t(sign | 0x7C00u | (mant ? 0x200u : 0u)); // Inf/NaN
+    if (exp >= 31) return uint16_t(sign | 0x7C00u); // Переполнение - бесконечность
+    if (exp <= 0){
+        // Денормализованные числа половинной точности
+        if (exp < -10) return uint16_t(sign);
+        mant |= 0x800000u;
+        const int shift = 14 - exp;
+        uint32_t half = mant >> shift;
+        const uint32_t rest = mant & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) ++half; // Округление к четному
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half = sign | (uint32_t(exp) << 10) | (mant >> 13);
+    const uint32_t rest = mant & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) ++half; // Округление к четному (перенос в порядок корректен)
+    return uint16_t(half);
+}
+
+uint32_t packNormal(const Vec3& n)
+{
+    auto pack = [](float v) -> uint32_t {
+        v = std::max(-1.0f, std::min(1.0f, v));
+        return uint32_t(int32_t(std::lround(v * 511.0f))) & 0x3FFu;
+    };
+    const Vec3 u = normalize(n);
+    return pack(u.x) | (pack(u.y) << 10) | (pack(u.z) << 20);
+}
+
+} // namespace
+
+const VertexFormat& VertexFormat::standard()
+{
+    static const VertexFormat format = {
+        {
+            {AttribPos,    3, GL_FLOAT, false, unsigned(offsetof(Vertex, pos))},
+            {AttribNormal, 3, GL_FLOAT, false, unsigned(offsetof(Vertex, nrm))},
+            {AttribUV,     2, GL_FLOAT, false, unsigned(offsetof(Vertex, uv))},
+        },
+        sizeof(Vertex)
+    };
+    return format;
+}
+
+const VertexFormat& VertexFormat::quantized()
+{
+    static const VertexFormat format = {
+        {
+            {AttribPos,    3, GL_UNSIGNED_SHORT,          true,  unsigned(offsetof(QuantizedVertex, pos))},
+            {AttribNormal, 4, GL_INT_2_10_10_10_REV,      true,  unsigned(offsetof(QuantizedVertex, nrm))},
+            {AttribUV,     2, GL_HALF_FLOAT,              false, unsigned(offsetof(QuantizedVertex, uv))},
+        },
+        sizeof(QuantizedVertex)
+    };
+    return format;
+}
+
+void Mesh::upload(QOpenGLFunctions_3_3_Core* f, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, Layout layout)
 {
-    m_indexCount = (int)indices.size();
-    if (!m_vao) f->glGenVertexArrays(1, &m_vao);
-    if (!m_vbo) f->glGenBuffers(1, &m_vbo);
-    if (!m_ebo) f->glGenBuffers(1, &m_ebo);
+    upload(f, vertices.data(), vertices.size(), indices.data(), indices.size(), layout);
+}
+
+void Mesh::upload(QOpenGLFunctions_3_3_Core* f, const Vertex* vertices, size_t vertexCount, const unsigned* indices, size_t indexCount,
+                  Layout layout)
+{
+    release(f);
+    m_indexCount = (int)indexCount;
+    m_bounds = Bounds::fromPositions(vertices, vertexCount);
+
+    const VertexFormat* format = &VertexFormat::standard();
+    const void* vertexData = vertices;
+    std::vector<QuantizedVertex> packed;
+    if (layout == Layout::Quantized && vertexCount > 0){
+        // Позиции квантуются в пределах ограничивающего параллелепипеда сетки
+        const Vec3 mn = m_bounds.min, mx = m_bounds.max;
+        m_posOffset = mn;
+        m_posScale = mx - mn;
+
+        auto quantize = [](float v, float lo, float extent) -> uint16_t {
+            if (extent <= 0.0f) return 0;
+            const float t = std::max(0.0f, std::min(1.0f, (v - lo) / extent));
+            return uint16_t(std::lround(t * 65535.0f));
+        };
+
+        packed.resize(vertexCount);
+        for (size_t k = 0; k < vertexCount; ++k){
+            const Vertex& v = vertices[k];
+            QuantizedVertex& q = packed[k];
+            q.pos[0] = quantize(v.pos.x, mn.x, m_posScale.x);
+            q.pos[1] = quantize(v.pos.y, mn.y, m_posScale.y);
+            q.pos[2] = quantize(v.pos.z, mn.z, m_posScale.z);
+            q.pos[3] = 0;
+            q.nrm = packNormal(v.nrm);
+            q.uv[0] = floatToHalf(v.uv.x);
+            q.uv[1] = floatToHalf(v.uv.y);
+        }
+        format = &VertexFormat::quantized();
+        vertexData = packed.data();
+    } else {
+        m_posScale = {1.0f, 1.0f, 1.0f};
+        m_posOffset = {0.0f, 0.0f, 0.0f};
+    }
+
+    // 16-битные индексы, если их диапазона хватает (индексы локальны для сетки,
+    // смещение до ее вершин в общем буфере добавляет baseVertex)
+    std::vector<uint16_t> narrow;
+    const void* indexData = indices;
+    size_t indexBytes = indexCount * sizeof(unsigned);
+    if (vertexCount <= std::numeric_limits<uint16_t>::max() + size_t(1)){
+        narrow.assign(indices, indices + indexCount);
+        m_indexType = GL_UNSIGNED_SHORT;
+        indexData = narrow.data();
+        indexBytes = indexCount * sizeof(uint16_t);
+    } else {
+        m_indexType = GL_UNSIGNED_INT;
+    }
+
+    m_range = GeometryArena::instance().upload(f, *format, vertexData, vertexCount, indexData, indexBytes);
+    m_gpuBytes = isValid() ? vertexCount * format->stride + indexBytes : 0;
+}
+
+void Mesh::setLods(const std::vector<MeshLod>& lods)
+{
+    m_lods = lods;
+}
 
-    f->glBindVertexArray(m_vao);
+void Mesh::lodRange(int lod, int& count, size_t& byteOffset) const
+{
+    count = m_indexCount;
+    size_t offset = 0;
+    if (!m_lods.empty()){
+        const MeshLod& l = m_lods[std::max(0, std::min(lod, (int)m_lods.size() - 1))];
+        count = (int)l.indexCount;
+        offset = l.indexOffset;
+    }
+    const size_t indexSize = (m_indexType == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(unsigned);
+    byteOffset = m_range.indexOffset + offset * indexSize;
+}
 
-    f->glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    f->glBufferData(GL_ARRAY_BUFFER, (int)(vertices.size()*sizeof(Vertex)), vertices.data(), GL_STATIC_DRAW);
+void Mesh::setPosAttribs(QOpenGLFunctions_3_3_Core* f) const
+{
+    // Постоянные атрибуты не входят в состояние VAO и задаются перед каждым вызовом
+    // (одинаковые значения подряд отсекает GLState)
+    GLState& state = GLState::instance();
+    state.vertexAttrib3f(f, AttribPosScale, m_posScale.x, m_posScale.y, m_posScale.z);
+    state.vertexAttrib3f(f, AttribPosOffset, m_posOffset.x, m_posOffset.y, m_posOffset.z);
+}
 
-    f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-    f->glBufferData(GL_ELEMENT_ARRAY_BUFFER, (int)(indices.size()*sizeof(unsigned)), indices.data(), GL_STATIC_DRAW);
+void Mesh::draw(QOpenGLFunctions_3_3_Core* f, int lod) const
+{
+    if (!isValid()) return;
+
+    int count = 0;
+    size_t offset = 0;
+    lodRange(lod, count, offset);
+    setPosAttribs(f);
+
+    // Все сетки одного формата лежат в одном пуле, поэтому VAO между ними не переключается
+    GeometryArena::instance().bind(f, m_range);
+    f->glDrawElementsBaseVertex(GL_TRIANGLES, count, m_indexType, (void*)offset, (GLint)m_range.firstVertex);
+}
+
+void Mesh::drawInstanced(QOpenGLFunctions_3_3_Core* f, const InstanceBatch& batch, int lod) const
+{
+    if (!isValid() || batch.count <= 0) return;
 
-    // Вершинные атрибуты: 0 - позиция вершины, 1 - нормаль, 2 - текстурные координаты (UV)
-    f->glEnableVertexAttribArray(0);
-    f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, pos));
-    f->glEnableVertexAttribArray(1);
-    f->glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, nrm));
-    f->glEnableVertexAttribArray(2);
-    f->glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+    int count = 0;
+    size_t offset = 0;
+    lodRange(lod, count, offset);
+    setPosAttribs(f);
 
-    f->glBindVertexArray(0);
+    GeometryArena::instance().bind(f, m_range);
+    batch.bindAttribs(f);
+    f->glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, m_indexType, (void*)offset, batch.count,
+                                         (GLint)m_range.firstVertex);
 }
 
-void Mesh::draw(QOpenGLFunctions_3_3_Core* f) const
+void Mesh::release(QOpenGLFunctions_3_3_Core*)
 {
-    f->glBindVertexArray(m_vao);
-    f->glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr);
-    f->glBindVertexArray(0);
+    GeometryArena::instance().free(m_range);
+    m_range = GeometryArena::Allocation();
+    m_indexCount = 0;
+    m_gpuBytes = 0;
+    m_lods.clear();
+    m_bounds = Bounds();
 }
@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <QOpenGLFunctions_3_3_Core>
+#include "bounds.h"
+#include "geometryarena.h"
+#include "instancestream.h"
 #include "math3d.h"
 
 struct Vertex {
@@ -11,20 +14,103 @@ struct Vertex {
     Vec2 uv;
 };
 
+// Уровень детализации: диапазон индексного буфера сетки
+struct MeshLod
+{
+    unsigned indexOffset = 0;
+    unsigned indexCount = 0;
+    float error = 0.0f; // Отклонение от исходной поверхности (единицы модели)
+};
+
+// Номера вершинных атрибутов, общие для всех шейдеров.
+// aPosScale/aPosOffset не хранятся в буфере: это постоянные значения атрибутов,
+// которыми шейдер восстанавливает позицию (pos = aPos * aPosScale + aPosOffset).
+// Атрибуты экземпляров берутся из InstanceStream (матрица занимает 4 слота)
+enum VertexAttribLocation
+{
+    AttribPos           = 0,
+    AttribNormal        = 1,
+    AttribUV            = 2,
+    AttribPosScale      = 3,
+    AttribPosOffset     = 4,
+    AttribInstanceModel = 5,
+    AttribInstanceTint  = 9
+};
+
+// Описание раскладки вершинного буфера для glVertexAttribPointer
+struct VertexFormat
+{
+    struct Attrib {
+        unsigned location;
+        int components;
+        unsigned type;
+        bool normalized;
+        unsigned offset;
+    };
+
+    std::vector<Attrib> attribs;
+    unsigned stride = 0;
+
+    // 32 байта: float позиция, нормаль и UV (Vertex как есть)
+    static const VertexFormat& standard();
+
+    // 16 байт: позиция - 3 x uint16 относительно границ сетки,
+    // нормаль - GL_INT_2_10_10_10_REV, UV - 2 x half float
+    static const VertexFormat& quantized();
+};
+
+// Сетка - диапазон общего хранилища GeometryArena; копии ссылаются на тот же диапазон,
+// освобождается он явно (release)
 class Mesh
 {
 public:
+    enum class Layout { Standard, Quantized };
+
+    static const int kMaxLods = 4;
+
     Mesh() = default;
     ~Mesh() = default;
 
-    void upload(QOpenGLFunctions_3_3_Core* f, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices);
-    void draw(QOpenGLFunctions_3_3_Core* f) const;
+    void upload(QOpenGLFunctions_3_3_Core* f, const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                Layout layout = Layout::Standard);
+    // Загрузка из произвольного буфера (например, отображенного в память файла)
+    void upload(QOpenGLFunctions_3_3_Core* f, const Vertex* vertices, size_t vertexCount, const unsigned* indices, size_t indexCount,
+                Layout layout = Layout::Standard);
+    void draw(QOpenGLFunctions_3_3_Core* f, int lod = 0) const;
+    // Один вызов на все экземпляры диапазона batch
+    void drawInstanced(QOpenGLFunctions_3_3_Core* f, const InstanceBatch& batch, int lod = 0) const;
+
+    // Диапазоны уровней детализации в загруженном индексном буфере
+    // (без вызова - один уровень на весь буфер)
+    void setLods(const std::vector<MeshLod>& lods);
+    int lodCount() const { return m_lods.empty() ? 1 : (int)m_lods.size(); }
 
-    bool isValid() const { return m_vao != 0; }
+    // Возврат диапазона в GeometryArena
+    void release(QOpenGLFunctions_3_3_Core* f);
+
+    bool isValid() const { return m_range.isValid(); }
+
+    // Объем данных сетки в видеопамяти (байты)
+    size_t gpuBytes() const { return m_gpuBytes; }
+
+    // Границы вершин в координатах сетки (вычисляются при загрузке)
+    const Bounds& bounds() const { return m_bounds; }
 
 private:
-    unsigned m_vao=0, m_vbo=0, m_ebo=0;
+    GeometryArena::Allocation m_range;
     int m_indexCount=0;
+    unsigned m_indexType = GL_UNSIGNED_INT;
+    size_t m_gpuBytes = 0;
+    std::vector<MeshLod> m_lods;
+    Bounds m_bounds;
+
+    // Восстановление квантованной позиции; для Layout::Standard - тождественное
+    Vec3 m_posScale{1.0f, 1.0f, 1.0f};
+    Vec3 m_posOffset{0.0f, 0.0f, 0.0f};
+
+    // Диапазон индексов уровня детализации (смещение в байтах от начала EBO пула)
+    void lodRange(int lod, int& count, size_t& byteOffset) const;
+    void setPosAttribs(QOpenGLFunctions_3_3_Core* f) const;
 };
 
 #endif // MESH_H
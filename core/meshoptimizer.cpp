@@ -0,0 +1,265 @@
+#include "meshoptimizer.h"
+
+#include <algorithm>
+
+namespace {
+
+// FIFO-кеш на отметках времени: вершина в кеше, если с момента ее загрузки
+// произошло не больше cacheSize промахов
+struct CacheSim
+{
+    std::vector<unsigned> stamp;
+    unsigned time;
+    unsigned size;
+
+    CacheSim(size_t vertexCount, unsigned cacheSize)
+        : stamp(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+    // Сброс без очистки массива: все отметки становятся устаревшими
+    void reset() { time += size + 1; }
+
+    bool access(unsigned v)
+    {
+        if (time - stamp[v] <= size) return false;
+        stamp[v] = time++;
+        return true;
+    }
+
+    unsigned triangle(const unsigned* tri)
+    {
+        return unsigned(access(tri[0])) + unsigned(access(tri[1])) + unsigned(access(tri[2]));
+    }
+};
+
+// Списки треугольников каждой вершины в плоском виде (CSR)
+struct Adjacency
+{
+    std::vector<unsigned> offsets; // vertexCount + 1
+    std::vector<unsigned> triangles;
+    std::vector<unsigned> counts;
+
+    Adjacency(const std::vector<unsigned>& indices, size_t vertexCount)
+        : offsets(vertexCount + 1, 0), triangles(indices.size()), counts(vertexCount, 0)
+    {
+        for (unsigned v : indices) ++counts[v];
+        for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + counts[v];
+
+        std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t k = 0; k < indices.size(); ++k) triangles[fill[indices[k]]++] = unsigned(k / 3);
+    }
+};
+
+} // namespace
+
+MeshOptimizer::Stats MeshOptimizer::analyze(const std::vector<unsigned>& indices, size_t vertexCount, unsigned cacheSize)
+{
+    Stats s;
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || vertexCount == 0) return s;
+
+    CacheSim cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (size_t t = 0; t < triCount; ++t) misses += cache.triangle(&indices[t * 3]);
+
+    // В знаменателе ATVR - только вершины, на которые есть ссылки
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (unsigned v : indices){
+        if (!used[v]){ used[v] = true; ++usedCount; }
+    }
+
+    s.acmr = float(misses) / float(triCount);
+    s.atvr = float(misses) / float(usedCount);
+    return s;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned>& indices, size_t vertexCount, unsigned cacheSize)
+{
+    // Tipsify (Sander, Nehab, Barczak 2007): треугольники выдаются веером вокруг
+    // текущей вершины, следующей выбирается соседняя вершина, которая еще
+    // останется в кеше после выдачи всех своих треугольников
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0) return;
+
+    Adjacency adj(indices, vertexCount);
+    std::vector<unsigned>& live = adj.counts; // Невыданные треугольники вершины
+    std::vector<unsigned> stamp(vertexCount, 0);
+    std::vector<bool> emitted(triCount, false);
+    std::vector<unsigned> deadEnd;
+    std::vector<unsigned> candidates;
+    std::vector<unsigned> out;
+    out.reserve(indices.size());
+
+    unsigned time = cacheSize + 1;
+    size_t cursor = 0;
+    long fan = 0;
+
+    while (fan >= 0){
+        candidates.clear();
+        for (unsigned k = adj.offsets[fan]; k < adj.offsets[fan + 1]; ++k){
+            const unsigned t = adj.triangles[k];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+
+            for (int c = 0; c < 3; ++c){
+                const unsigned v = indices[t * 3 + c];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (time - stamp[v] > cacheSize) stamp[v] = time++;
+            }
+        }
+
+        // Следующая вершина веера среди только что затронутых
+        long best = -1;
+        int bestPriority = -1;
+        for (unsigned v : candidates){
+            if (live[v] == 0) continue;
+            int priority = 0;
+            if (time - stamp[v] + 2 * live[v] <= cacheSize) priority = int(time - stamp[v]);
+            if (priority > bestPriority){
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        // Тупик: последние затронутые вершины, затем - первая с невыданными треугольниками
+        while (best < 0 && !deadEnd.empty()){
+            const unsigned v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) best = v;
+        }
+        while (best < 0 && cursor < vertexCount){
+            if (live[cursor] > 0) best = long(cursor);
+            ++cursor;
+        }
+        fan = best;
+    }
+
+    indices.swap(out);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices,
+                                     float threshold, unsigned cacheSize)
+{
+    // Треугольники делятся на кластеры по точкам разрыва кеша, затем кластеры
+    // сортируются так, чтобы обращенные наружу части модели рисовались первыми
+    const size_t triCount = indices.size() / 3;
+    if (triCount < 2) return;
+
+    // Жесткие границы: треугольник, все вершины которого промахнулись мимо кеша
+    std::vector<size_t> hard;
+    {
+        CacheSim cache(vertices.size(), cacheSize);
+        for (size_t t = 0; t < triCount; ++t){
+            if (cache.triangle(&indices[t * 3]) == 3) hard.push_back(t);
+        }
+        if (hard.empty() || hard[0] != 0) hard.insert(hard.begin(), 0);
+        hard.push_back(triCount);
+    }
+
+    // Мягкие границы внутри жестких кластеров: кластер закрывается, когда его
+    // ACMR опустился до threshold * ACMR всего жесткого кластера
+    std::vector<size_t> bounds;
+    CacheSim cache(vertices.size(), cacheSize);
+    for (size_t h = 0; h + 1 < hard.size(); ++h){
+        const size_t start = hard[h], end = hard[h + 1];
+
+        cache.reset();
+        size_t misses = 0;
+        for (size_t t = start; t < end; ++t) misses += cache.triangle(&indices[t * 3]);
+        const float target = threshold * float(misses) / float(end - start);
+
+        cache.reset();
+        size_t subStart = start;
+        size_t subMisses = 0;
+        bounds.push_back(start);
+        for (size_t t = start; t < end; ++t){
+            subMisses += cache.triangle(&indices[t * 3]);
+            if (t + 1 < end && float(subMisses) / float(t + 1 - subStart) <= target){
+                bounds.push_back(t + 1);
+                subStart = t + 1;
+                subMisses = 0;
+                cache.reset();
+            }
+        }
+    }
+    bounds.push_back(triCount);
+
+    // Центр модели по площадям треугольников
+    Vec3 meshCenter{0, 0, 0};
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triCount; ++t){
+        const Vec3& a = vertices[indices[t*3+0]].pos;
+        const Vec3& b = vertices[indices[t*3+1]].pos;
+        const Vec3& c = vertices[indices[t*3+2]].pos;
+        const Vec3 n = cross(b - a, c - a);
+        const float area = length(n);
+        meshCenter += (a + b + c) * (area / 3.0f);
+        meshArea += area;
+    }
+    if (meshArea > 0.0f) meshCenter = meshCenter * (1.0f / meshArea);
+
+    // Ключ кластера: насколько его средняя нормаль смотрит от центра модели
+    const size_t clusterCount = bounds.size() - 1;
+    std::vector<float> sortKey(clusterCount, 0.0f);
+    for (size_t k = 0; k < clusterCount; ++k){
+        Vec3 center{0, 0, 0};
+        Vec3 normal{0, 0, 0};
+        float area = 0.0f;
+        for (size_t t = bounds[k]; t < bounds[k + 1]; ++t){
+            const Vec3& a = vertices[indices[t*3+0]].pos;
+            const Vec3& b = vertices[indices[t*3+1]].pos;
+            const Vec3& c = vertices[indices[t*3+2]].pos;
+            const Vec3 n = cross(b - a, c - a);
+            const float w = length(n);
+            center += (a + b + c) * (w / 3.0f);
+            normal += n;
+            area += w;
+        }
+        if (area <= 0.0f) continue;
+        center = center * (1.0f / area);
+
+        sortKey[k] = dot(center - meshCenter, normalize(normal));
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t k = 0; k < clusterCount; ++k) order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return sortKey[a] > sortKey[b]; });
+
+    std::vector<unsigned> out;
+    out.reserve(indices.size());
+    for (size_t k : order){
+        out.insert(out.end(), indices.begin() + bounds[k] * 3, indices.begin() + bounds[k + 1] * 3);
+    }
+    indices.swap(out);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+    const unsigned kUnused = ~0u;
+    std::vector<unsigned> remap(vertices.size(), kUnused);
+    std::vector<Vertex> out;
+    out.reserve(vertices.size());
+
+    for (unsigned& idx : indices){
+        if (remap[idx] == kUnused){
+            remap[idx] = unsigned(out.size());
+            out.push_back(vertices[idx]);
+        }
+        idx = remap[idx];
+    }
+    vertices.swap(out);
+}
+
+void MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<unsigned>& indices, Stats* before, Stats* after)
+{
+    if (before) *before = analyze(indices, vertices.size());
+
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    if (after) *after = analyze(indices, vertices.size());
+}
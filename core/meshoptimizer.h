@@ -0,0 +1,42 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <vector>
+
+#include "mesh.h"
+
+// Оптимизация индексированной треугольной сетки перед выгрузкой в GPU:
+// 1) порядок треугольников под кеш вершин после преобразования (Tipsify);
+// 2) перестановка кластеров треугольников для уменьшения перерисовки (overdraw);
+// 3) перенумерация вершин в порядке первого использования (локальность выборки).
+// Набор треугольников и их ориентация не меняются.
+
+class MeshOptimizer
+{
+public:
+    static const unsigned kCacheSize = 16; // Модель FIFO-кеша вершин
+
+    struct Stats
+    {
+        float acmr = 0.0f; // Промахи кеша на треугольник (от 0.5 до 3)
+        float atvr = 0.0f; // Промахи кеша на вершину (1 - идеал)
+    };
+
+    // Оценка индексного буфера на модели FIFO-кеша заданного размера
+    static Stats analyze(const std::vector<unsigned>& indices, size_t vertexCount, unsigned cacheSize = kCacheSize);
+
+    static void optimizeVertexCache(std::vector<unsigned>& indices, size_t vertexCount, unsigned cacheSize = kCacheSize);
+
+    // Допускает рост ACMR не более чем в threshold раз ради лучшего порядка кластеров
+    static void optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices,
+                                 float threshold = 1.05f, unsigned cacheSize = kCacheSize);
+
+    // Неиспользуемые вершины удаляются
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+
+    // Все три шага; before/after - статистика до и после (если не nullptr)
+    static void optimize(std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+                         Stats* before = nullptr, Stats* after = nullptr);
+};
+
+#endif // MESHOPTIMIZER_H
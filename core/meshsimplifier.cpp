@@ -0,0 +1,413 @@
+#include "meshsimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
+#include "meshoptimizer.h"
+
+namespace {
+
+const unsigned kNone = ~0u;
+const unsigned kMany = ~0u - 1;
+
+// Вес квадрик плоскостей, перпендикулярных открытым ребрам (удерживает границы и швы)
+const double kEdgeWeight = 10.0;
+
+enum VertexKind { Manifold, Border, Seam, Locked };
+
+struct Quadric
+{
+    double a00 = 0, a11 = 0, a22 = 0, a10 = 0, a20 = 0, a21 = 0;
+    double b0 = 0, b1 = 0, b2 = 0;
+    double c = 0;
+    double w = 0;
+
+    // Плоскость n·p + d = 0 (n - единичная)
+    void addPlane(const Vec3& n, double d, double weight)
+    {
+        a00 += weight * n.x * n.x;
+        a11 += weight * n.y * n.y;
+        a22 += weight * n.z * n.z;
+        a10 += weight * n.y * n.x;
+        a20 += weight * n.z * n.x;
+        a21 += weight * n.z * n.y;
+        b0 += weight * n.x * d;
+        b1 += weight * n.y * d;
+        b2 += weight * n.z * d;
+        c  += weight * d * d;
+        w  += weight;
+    }
+
+    Quadric& operator+=(const Quadric& o)
+    {
+        a00 += o.a00; a11 += o.a11; a22 += o.a22;
+        a10 += o.a10; a20 += o.a20; a21 += o.a21;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2;
+        c += o.c;
+        w += o.w;
+        return *this;
+    }
+
+    // Средний квадрат расстояния от p до плоскостей квадрики
+    double error(const Vec3& p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+        const double rx = a00 * x + a10 * y + a20 * z;
+        const double ry = a10 * x + a11 * y + a21 * z;
+        const double rz = a20 * x + a21 * y + a22 * z;
+        const double r = rx * x + ry * y + rz * z + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return (w > 0.0) ? std::fabs(r) / w : 0.0;
+    }
+};
+
+uint64_t edgeKey(unsigned a, unsigned b) { return (uint64_t(a) << 32) | b; }
+
+bool hasEdge(const std::vector<uint64_t>& edges, unsigned a, unsigned b)
+{
+    return std::binary_search(edges.begin(), edges.end(), edgeKey(a, b));
+}
+
+// Топология текущего индексного буфера на уровне позиций (групп вершин).
+// Граница - ребро позиций без обратного; шов - ребро, открытое по UV
+// (UV с двух сторон различны), но закрытое по позициям. Вершины, разделенные
+// только по нормалям, заранее сведены в одну и швов не образуют
+struct Topology
+{
+    std::vector<uint64_t> edges;     // Ориентированные ребра по индексам вершин
+    std::vector<uint64_t> posEdges;  // То же по группам
+    std::vector<unsigned> openOut;   // Соседи по границе (по группам)
+    std::vector<unsigned> openInc;
+    std::vector<unsigned> seam[2];   // Соседи по шву (по группам)
+    std::vector<unsigned char> kind; // По группам
+
+    void build(const std::vector<unsigned>& indices, const std::vector<unsigned>& group, size_t vertexCount)
+    {
+        edges.clear();
+        posEdges.clear();
+        for (size_t t = 0; t < indices.size(); t += 3){
+            for (int e = 0; e < 3; ++e){
+                const unsigned a = indices[t + e], b = indices[t + (e + 1) % 3];
+                edges.push_back(edgeKey(a, b));
+                posEdges.push_back(edgeKey(group[a], group[b]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::sort(posEdges.begin(), posEdges.end());
+
+        auto note = [](unsigned& slot, unsigned v){
+            if (slot == kNone) slot = v;
+            else if (slot != v) slot = kMany;
+        };
+
+        openOut.assign(vertexCount, kNone);
+        openInc.assign(vertexCount, kNone);
+        for (uint64_t e : posEdges){
+            const unsigned a = unsigned(e >> 32), b = unsigned(e);
+            if (hasEdge(posEdges, b, a)) continue;
+            note(openOut[a], b);
+            note(openInc[b], a);
+        }
+
+        seam[0].assign(vertexCount, kNone);
+        seam[1].assign(vertexCount, kNone);
+        auto addSeam = [&](unsigned g, unsigned nbr){
+            if (seam[0][g] == kNone || seam[0][g] == nbr) seam[0][g] = nbr;
+            else if (seam[1][g] == kNone || seam[1][g] == nbr) seam[1][g] = nbr;
+            else seam[0][g] = seam[1][g] = kMany;
+        };
+        for (uint64_t e : edges){
+            const unsigned a = unsigned(e >> 32), b = unsigned(e);
+            if (hasEdge(edges, b, a)) continue;
+            const unsigned ga = group[a], gb = group[b];
+            if (!hasEdge(posEdges, gb, ga)) continue; // Граница, а не шов
+            addSeam(ga, gb);
+            addSeam(gb, ga);
+        }
+
+        auto single = [](unsigned v){ return v != kNone && v != kMany; };
+
+        kind.assign(vertexCount, Locked);
+        for (size_t g = 0; g < vertexCount; ++g){
+            const bool open = openOut[g] != kNone || openInc[g] != kNone;
+            const bool seamed = seam[0][g] != kNone;
+            if (!open && !seamed) kind[g] = Manifold;
+            else if (open && !seamed && single(openOut[g]) && single(openInc[g])) kind[g] = Border;
+            else if (!open && single(seam[0][g]) && single(seam[1][g])) kind[g] = Seam;
+        }
+    }
+
+    // Куда может сместиться группа g0: в любую соседнюю (внутренняя вершина)
+    // либо только вдоль своей границы или шва
+    bool canCollapse(unsigned g0, unsigned g1) const
+    {
+        switch (kind[g0]){
+        case Manifold: return true;
+        case Border:   return openOut[g0] == g1 || openInc[g0] == g1;
+        case Seam:     return seam[0][g0] == g1 || seam[1][g0] == g1;
+        default:       return false;
+        }
+    }
+};
+
+struct Collapse
+{
+    unsigned g0, g1; // Группа g0 переходит в позицию группы g1
+    double cost;
+};
+
+} // namespace
+
+std::vector<unsigned> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                                               size_t targetIndexCount, float* error)
+{
+    std::vector<unsigned> result = indices;
+    if (error) *error = 0.0f;
+    const size_t vertexCount = vertices.size();
+    if (result.size() <= targetIndexCount || vertexCount == 0) return result;
+
+    // Разрывы только по нормалям (жесткие ребра) швами не считаются: упрощение идет
+    // по вершинам с уникальными позицией и UV, а нормаль подбирается в конце.
+    // Иначе граненые модели (транспорт) почти целиком состояли бы из неподвижных углов
+    std::vector<unsigned> byAttrib(vertexCount);
+    for (size_t k = 0; k < vertexCount; ++k) byAttrib[k] = unsigned(k);
+    auto attribKey = [&](unsigned v){
+        const Vertex& x = vertices[v];
+        return std::make_tuple(x.pos.x, x.pos.y, x.pos.z, x.uv.x, x.uv.y);
+    };
+    std::stable_sort(byAttrib.begin(), byAttrib.end(), [&](unsigned a, unsigned b){ return attribKey(a) < attribKey(b); });
+
+    std::vector<unsigned> canonical(vertexCount);
+    std::vector<unsigned> attribRun(vertexCount); // Начало серии вершины в byAttrib
+    for (size_t k = 0; k < vertexCount; ++k){
+        const unsigned v = byAttrib[k];
+        const bool same = k > 0 && attribKey(byAttrib[k - 1]) == attribKey(v);
+        canonical[v] = same ? canonical[byAttrib[k - 1]] : v;
+        attribRun[v] = same ? attribRun[byAttrib[k - 1]] : unsigned(k);
+    }
+    for (unsigned& v : result) v = canonical[v];
+
+    // Группа вершины - первая вершина с той же позицией
+    std::vector<unsigned> byPosition(vertexCount);
+    for (size_t k = 0; k < vertexCount; ++k) byPosition[k] = unsigned(k);
+    auto posKey = [&](unsigned v){ const Vec3& p = vertices[v].pos; return std::make_tuple(p.x, p.y, p.z); };
+    std::stable_sort(byPosition.begin(), byPosition.end(), [&](unsigned a, unsigned b){ return posKey(a) < posKey(b); });
+
+    std::vector<unsigned> group(vertexCount);
+    for (size_t k = 0; k < vertexCount; ++k){
+        const unsigned v = byPosition[k];
+        group[v] = (k > 0 && posKey(byPosition[k - 1]) == posKey(v)) ? group[byPosition[k - 1]] : v;
+    }
+
+    Topology topo;
+    topo.build(result, group, vertexCount);
+
+    // Квадрики плоскостей треугольников (вес - площадь) и плоскостей,
+    // перпендикулярных границам и швам
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < result.size(); t += 3){
+        const unsigned* tri = &result[t];
+        const Vec3& p0 = vertices[tri[0]].pos;
+        const Vec3& p1 = vertices[tri[1]].pos;
+        const Vec3& p2 = vertices[tri[2]].pos;
+        const Vec3 cr = cross(p1 - p0, p2 - p0);
+        const float area = length(cr) * 0.5f;
+        if (area <= 0.0f) continue;
+        const Vec3 n = normalize(cr);
+        const double d = -dot(n, p0);
+        for (int k = 0; k < 3; ++k) quadrics[group[tri[k]]].addPlane(n, d, area);
+
+        for (int e = 0; e < 3; ++e){
+            const unsigned a = tri[e], b = tri[(e + 1) % 3];
+            if (hasEdge(topo.edges, b, a)) continue;
+            const Vec3& pa = vertices[a].pos;
+            const Vec3 edge = vertices[b].pos - pa;
+            const Vec3 en = normalize(cross(edge, n));
+            const double ed = -dot(en, pa);
+            const double weight = double(dot(edge, edge)) * kEdgeWeight;
+            quadrics[group[a]].addPlane(en, ed, weight);
+            quadrics[group[b]].addPlane(en, ed, weight);
+        }
+    }
+
+    const size_t targetTris = targetIndexCount / 3;
+    double maxError = 0.0;
+
+    std::vector<unsigned> collapseRemap(vertexCount);
+    for (size_t k = 0; k < vertexCount; ++k) collapseRemap[k] = unsigned(k);
+    std::vector<unsigned char> locked(vertexCount, 0);
+    std::vector<Collapse> candidates;
+    std::vector<unsigned> adjOffsets, adjTris;
+    std::vector<std::pair<unsigned, unsigned>> wedgeMap;
+
+    for (int pass = 0; pass < 1000 && result.size() / 3 > targetTris; ++pass){
+        if (pass > 0) topo.build(result, group, vertexCount);
+
+        const size_t triCount = result.size() / 3;
+
+        // Кандидаты: для каждого ребра - более дешевое из допустимых направлений
+        candidates.clear();
+        for (size_t t = 0; t < result.size(); t += 3){
+            for (int e = 0; e < 3; ++e){
+                const unsigned ga = group[result[t + e]], gb = group[result[t + (e + 1) % 3]];
+                if (ga == gb) continue;
+                const bool okAB = topo.canCollapse(ga, gb);
+                const bool okBA = topo.canCollapse(gb, ga);
+                const double costAB = okAB ? quadrics[ga].error(vertices[gb].pos) : 0.0;
+                const double costBA = okBA ? quadrics[gb].error(vertices[ga].pos) : 0.0;
+                if (okAB && (!okBA || costAB <= costBA)) candidates.push_back({ga, gb, costAB});
+                else if (okBA) candidates.push_back({gb, ga, costBA});
+            }
+        }
+        if (candidates.empty()) break;
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y){ return x.cost < y.cost; });
+
+        // Треугольники, содержащие каждую группу вершин
+        adjOffsets.assign(vertexCount + 1, 0);
+        for (unsigned v : result) ++adjOffsets[group[v] + 1];
+        for (size_t k = 0; k < vertexCount; ++k) adjOffsets[k + 1] += adjOffsets[k];
+        adjTris.resize(result.size());
+        {
+            std::vector<unsigned> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+            for (size_t k = 0; k < result.size(); ++k) adjTris[fill[group[result[k]]]++] = unsigned(k / 3);
+        }
+
+        // Схлопывание не должно переворачивать соседние треугольники
+        auto flips = [&](unsigned g0, unsigned g1) -> bool {
+            const Vec3& p1 = vertices[g1].pos;
+            for (unsigned k = adjOffsets[g0]; k < adjOffsets[g0 + 1]; ++k){
+                const unsigned* tri = &result[adjTris[k] * 3];
+                if (group[tri[0]] == g1 || group[tri[1]] == g1 || group[tri[2]] == g1) continue;
+
+                Vec3 p[3], q[3];
+                for (int c = 0; c < 3; ++c){
+                    p[c] = vertices[tri[c]].pos;
+                    q[c] = (group[tri[c]] == g0) ? p1 : p[c];
+                }
+                if (dot(cross(p[1] - p[0], p[2] - p[0]), cross(q[1] - q[0], q[2] - q[0])) <= 0.0f) return true;
+            }
+            return false;
+        };
+
+        // Каждая копия вершины g0 (своя UV/нормаль) должна перейти в ту копию g1,
+        // с которой она соединена ребром, иначе атрибуты поверхности разорвутся
+        auto mapWedges = [&](unsigned g0, unsigned g1) -> bool {
+            wedgeMap.clear();
+            auto find = [&](unsigned w) -> unsigned {
+                for (const auto& m : wedgeMap) if (m.first == w) return m.second;
+                return kNone;
+            };
+            for (unsigned k = adjOffsets[g0]; k < adjOffsets[g0 + 1]; ++k){
+                const unsigned* tri = &result[adjTris[k] * 3];
+                unsigned w0 = kNone, w1 = kNone;
+                for (int c = 0; c < 3; ++c){
+                    if (group[tri[c]] == g0) w0 = tri[c];
+                    else if (group[tri[c]] == g1) w1 = tri[c];
+                }
+                if (w1 == kNone) continue;
+                const unsigned prev = find(w0);
+                if (prev == kNone) wedgeMap.push_back({w0, w1});
+                else if (prev != w1) return false;
+            }
+            for (unsigned k = adjOffsets[g0]; k < adjOffsets[g0 + 1]; ++k){
+                const unsigned* tri = &result[adjTris[k] * 3];
+                for (int c = 0; c < 3; ++c){
+                    if (group[tri[c]] == g0 && find(tri[c]) == kNone) return false;
+                }
+            }
+            return true;
+        };
+
+        // За проход выполняются только самые дешевые схлопывания: иначе из-за блокировок
+        // соседей в проход попадали бы дорогие ребра из конца списка
+        const size_t need = std::min(candidates.size(), (triCount - targetTris) / 2 + 1);
+        const double costBound = candidates[need - 1].cost * 1.5;
+
+        size_t removed = 0;
+        size_t collapses = 0;
+        for (const Collapse& c : candidates){
+            if (c.cost > costBound) break;
+            if (locked[c.g0] || locked[c.g1]) continue;
+            if (flips(c.g0, c.g1) || !mapWedges(c.g0, c.g1)) continue;
+
+            for (const auto& m : wedgeMap) collapseRemap[m.first] = m.second;
+            quadrics[c.g1] += quadrics[c.g0];
+            maxError = std::max(maxError, c.cost);
+
+            // Соседи g0 блокируются до конца прохода: их треугольники изменились
+            locked[c.g0] = locked[c.g1] = 1;
+            for (unsigned k = adjOffsets[c.g0]; k < adjOffsets[c.g0 + 1]; ++k){
+                const unsigned* tri = &result[adjTris[k] * 3];
+                for (int e = 0; e < 3; ++e) locked[group[tri[e]]] = 1;
+            }
+
+            ++collapses;
+            removed += (topo.kind[c.g0] == Border) ? 1 : 2;
+            if (triCount - std::min(triCount, removed) <= targetTris) break;
+        }
+        if (collapses == 0) break;
+
+        // Применение схлопываний и удаление вырожденных треугольников
+        size_t out = 0;
+        for (size_t t = 0; t < result.size(); t += 3){
+            const unsigned a = collapseRemap[result[t]];
+            const unsigned b = collapseRemap[result[t + 1]];
+            const unsigned c = collapseRemap[result[t + 2]];
+            if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c]) continue;
+            result[out++] = a;
+            result[out++] = b;
+            result[out++] = c;
+        }
+        result.resize(out);
+
+        for (size_t k = 0; k < vertexCount; ++k) collapseRemap[k] = unsigned(k);
+        std::fill(locked.begin(), locked.end(), 0);
+    }
+
+    // Нормаль каждого угла - та из копий вершины, что ближе к нормали итогового треугольника
+    for (size_t t = 0; t < result.size(); t += 3){
+        unsigned* tri = &result[t];
+        const Vec3 n = normalize(cross(vertices[tri[1]].pos - vertices[tri[0]].pos,
+                                       vertices[tri[2]].pos - vertices[tri[0]].pos));
+        for (int c = 0; c < 3; ++c){
+            unsigned best = tri[c];
+            float bestDot = -2.0f;
+            for (size_t k = attribRun[tri[c]]; k < vertexCount && canonical[byAttrib[k]] == tri[c]; ++k){
+                const float d = dot(vertices[byAttrib[k]].nrm, n);
+                if (d > bestDot){ bestDot = d; best = byAttrib[k]; }
+            }
+            tri[c] = best;
+        }
+    }
+
+    if (error) *error = float(std::sqrt(maxError));
+    return result;
+}
+
+void MeshSimplifier::buildLods(const std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+                               std::vector<MeshLod>& lods, int levels)
+{
+    lods.clear();
+    const size_t baseCount = indices.size();
+    lods.push_back({0, unsigned(baseCount), 0.0f});
+
+    const std::vector<unsigned> base(indices.begin(), indices.end());
+    float prevError = 0.0f;
+    for (int level = 1; level < levels; ++level){
+        const size_t target = (baseCount >> level) / 3 * 3;
+        if (target < 3) break;
+
+        float err = 0.0f;
+        std::vector<unsigned> lod = simplify(vertices, base, target, &err);
+
+        // Уровень, сокративший меньше 20% треугольников предыдущего, не нужен
+        if (lod.empty() || lod.size() * 5 > size_t(lods.back().indexCount) * 4) break;
+
+        MeshOptimizer::optimizeVertexCache(lod, vertices.size());
+
+        prevError = std::max(prevError, err);
+        lods.push_back({unsigned(indices.size()), unsigned(lod.size()), prevError});
+        indices.insert(indices.end(), lod.begin(), lod.end());
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+
+#include "mesh.h"
+
+// Упрощение треугольной сетки схлопыванием ребер по квадрикам ошибки (Garland-Heckbert).
+// Массив вершин не меняется: результат - новый индексный буфер над теми же вершинами,
+// поэтому все уровни детализации части модели делят один вершинный буфер.
+// Открытые границы и UV-швы сохраняются: такие вершины сдвигаются только вдоль своей
+// границы или шва, а углы остаются на месте. Разрыв только по нормалям швом не считается.
+
+class MeshSimplifier
+{
+public:
+    // error - максимальное отклонение поверхности в единицах модели
+    static std::vector<unsigned> simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                                          size_t targetIndexCount, float* error = nullptr);
+
+    // Уровни детализации 1..levels-1 (каждый вдвое меньше по треугольникам) дописываются
+    // в конец indices; lods описывает диапазоны всех уровней, уровень 0 - исходные индексы.
+    // Построение прекращается, если очередной уровень почти не уменьшается
+    static void buildLods(const std::vector<Vertex>& vertices, std::vector<unsigned>& indices,
+                          std::vector<MeshLod>& lods, int levels = Mesh::kMaxLods);
+};
+
+#endif // MESHSIMPLIFIER_H
@@ -0,0 +1,319 @@
+#include "modelcache.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QFileInfo>
+
+#include "assetloader.h"
+#include "bakedmesh.h"
+#include "meshoptimizer.h"
+#include "meshsimplifier.h"
+
+static void normalizeVertices(std::vector<Vertex>& v, float targetMaxDim)
+{
+    if (v.empty()) return;
+
+    Vec3 mn = v[0].pos, mx = v[0].pos;
+    for (const auto& vx : v){
+        mn.x = std::min(mn.x, vx.pos.x); mn.y = std::min(mn.y, vx.pos.y); mn.z = std::min(mn.z, vx.pos.z);
+        mx.x = std::max(mx.x, vx.pos.x); mx.y = std::max(mx.y, vx.pos.y); mx.z = std::max(mx.z, vx.pos.z);
+    }
+    Vec3 size = {mx.x-mn.x, mx.y-mn.y, mx.z-mn.z};
+    float maxDim = std::max(size.x, std::max(size.y, size.z));
+    if (maxDim < 1e-6f) return;
+
+    // Центрирование по XZ и установка на опорную плоскость по minY = 0
+    // (для транспорта - полотно моста, для лодки - ватерлиния)
+    Vec3 center = {(mn.x+mx.x)*0.5f, mn.y, (mn.z+mx.z)*0.5f};
+
+    float s = targetMaxDim / maxDim;
+    for (auto& vx : v){
+        vx.pos = (vx.pos - center) * s;
+    }
+}
+
+static void rotateXNeg90(std::vector<Vertex>& v)
+{
+    // Поворот позиций и нормалей вокруг оси X на -90 градусов
+    for (auto& vx : v){
+        float y = vx.pos.y, z = vx.pos.z;
+        vx.pos.y = z;
+        vx.pos.z = -y;
+
+        float ny = vx.nrm.y, nz = vx.nrm.z;
+        vx.nrm.y = nz;
+        vx.nrm.z = -ny;
+    }
+}
+
+static void rotateY180(std::vector<Vertex>& v)
+{
+    // Поворот на 180 градусов вокруг оси Y (разворот модели)
+    for (auto& vert : v){
+        vert.pos.x = -vert.pos.x;
+        vert.pos.z = -vert.pos.z;
+        vert.nrm.x = -vert.nrm.x;
+        vert.nrm.z = -vert.nrm.z;
+    }
+}
+
+int Model::selectLod(float pixelsPerUnit) const
+{
+    int lod = 0;
+    for (int l = 1; l < (int)lodErrors.size(); ++l){
+        if (lodErrors[l] * pixelsPerUnit > kLodPixelError) break;
+        lod = l;
+    }
+    return lod;
+}
+
+bool Model::raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const
+{
+    const Vec3 invDir = rayInverse(dir);
+    bool found = false;
+    for (size_t k = 0; k < parts.size(); ++k){
+        const Bounds& b = parts[k].mesh.bounds();
+        float entry = 0.0f;
+        if (b.isEmpty() || !rayBoxEntry(b.min, b.max, origin, invDir, maxT, entry)) continue;
+        if (parts[k].bvh.raycast(origin, dir, maxT, hit)){
+            hit.part = int(k);
+            maxT = hit.t;
+            found = true;
+        }
+    }
+    return found;
+}
+
+ModelCache& ModelCache::instance()
+{
+    static ModelCache cache;
+    return cache;
+}
+
+QString ModelCache::makeKey(const ModelDesc& desc)
+{
+    return QString("%1|%2|%3|%4|%5")
+        .arg(desc.path)
+        .arg(desc.targetSize)
+        .arg(desc.rotXNeg90 ? 1 : 0)
+        .arg(desc.rotY180 ? 1 : 0)
+        .arg(desc.loadMaps ? 1 : 0);
+}
+
+namespace {
+
+// Меняется вместе с предобработкой моделей, чтобы устаревший кеш .lhbm не использовался
+const int kPrepareVersion = 3;
+
+// CPU-данные модели, подготовленные рабочим потоком для выгрузки в GPU
+struct PreparedPart
+{
+    const Vertex* vertices = nullptr;
+    size_t vertexCount = 0;
+    const unsigned* indices = nullptr;
+    size_t indexCount = 0;
+    ObjLoader::Material material;
+    std::vector<MeshLod> lods;
+    Bounds bounds;
+    TriangleBvh bvh;
+
+    // Карта с пустым путем отсутствует (или загрузка текстур не запрашивалась);
+    // пустые данные при заданном пути - текстура уже есть в реестре
+    struct Map {
+        TextureDesc desc;
+        BakedTextureHandle baked;
+    };
+    Map mapKd;
+    Map mapKs;
+    Map mapKn;
+};
+
+struct PreparedModel
+{
+    BakedMesh baked;                         // Данные кеша .lhbm (отображены в память)
+    std::vector<ObjLoader::ObjPart> source;  // Либо результат разбора OBJ
+    std::vector<PreparedPart> parts;         // Указывают в baked или source
+};
+
+// loaded - уже прочитанные текстуры модели (части часто ссылаются на одни файлы)
+void loadMaps(const ModelDesc& desc, PreparedPart& part, std::unordered_map<QString, BakedTextureHandle>& loaded)
+{
+    // Текстуры, описанные в MTL файле, упакованы как ресурсы рядом с моделью
+    auto loadMap = [&](const QString& mapName, TextureUsage usage, PreparedPart::Map& out){
+        if (mapName.isEmpty()) return;
+        const int slash = desc.path.lastIndexOf('/');
+        const QString dir = (slash >= 0) ? desc.path.left(slash+1) : QString(":/models/");
+        out.desc.path = dir + QFileInfo(mapName).fileName();
+        out.desc.srgb = (usage == TextureUsage::Color);
+        out.desc.usage = usage;
+        if (TextureRegistry::instance().contains(out.desc)) return;
+
+        // Кеш .lhbt либо запекание при первом обращении
+        const QString key = out.desc.path + QString("|%1").arg(int(usage));
+        auto it = loaded.find(key);
+        if (it == loaded.end()){
+            auto baked = std::make_shared<BakedTexture>();
+            if (!baked->load(out.desc.path, out.desc.srgb, usage)) baked.reset();
+            it = loaded.emplace(key, std::move(baked)).first;
+        }
+        out.baked = it->second;
+    };
+
+    loadMap(part.material.mapKd, TextureUsage::Color, part.mapKd);
+    loadMap(part.material.mapKs, TextureUsage::Color, part.mapKs);
+    loadMap(part.material.mapKn, TextureUsage::Normal, part.mapKn);
+}
+
+// Выполняется в рабочем потоке, GL не используется
+void prepare(const ModelDesc& desc, const QString& key, PreparedModel& out)
+{
+    // Сначала запеченный кеш (.lhbm): вершины уже повернуты и нормализованы
+    const QString bakedPath = BakedMesh::cacheFilePath(key);
+    const QByteArray hash = BakedMesh::sourceHash(desc.path, key + QString("|v%1").arg(kPrepareVersion));
+
+    if (out.baked.open(bakedPath, hash)){
+        for (const auto& part : out.baked.parts()){
+            PreparedPart pp;
+            pp.vertices = part.vertices;
+            pp.vertexCount = part.vertexCount;
+            pp.indices = part.indices;
+            pp.indexCount = part.indexCount;
+            pp.material = part.material;
+            pp.lods = part.lods;
+            pp.bounds = part.bounds;
+            out.parts.push_back(std::move(pp));
+        }
+    } else {
+        auto& parts = out.source;
+        bool fromSource = ObjLoader::loadParts(desc.path, parts);
+        if (!fromSource){
+            // Модель не найдена - вместо нее используется единичный куб
+            std::vector<Vertex> v;
+            std::vector<unsigned> ind;
+            ObjLoader::load(":/models/cube.obj", v, ind);
+
+            parts.clear();
+            ObjLoader::ObjPart p;
+            p.vertices = std::move(v);
+            p.indices  = std::move(ind);
+            p.material.name = "default";
+            p.material.kd = {1,1,1};
+            parts.push_back(std::move(p));
+        }
+
+        for (auto& part : parts){
+            if (desc.rotXNeg90) rotateXNeg90(part.vertices);
+            if (desc.rotY180)   rotateY180(part.vertices);
+            normalizeVertices(part.vertices, desc.targetSize);
+
+            MeshOptimizer::Stats before, after;
+            MeshOptimizer::optimize(part.vertices, part.indices, &before, &after);
+            qDebug().nospace() << desc.path << " [" << part.material.name << "]: ACMR "
+                               << before.acmr << " -> " << after.acmr << ", ATVR "
+                               << before.atvr << " -> " << after.atvr;
+
+            MeshSimplifier::buildLods(part.vertices, part.indices, part.lods);
+            part.bounds = Bounds::fromPositions(part.vertices.data(), part.vertices.size());
+        }
+
+        // Запекание для следующих запусков (заглушка-куб не кешируется)
+        if (fromSource) BakedMesh::write(bakedPath, hash, parts);
+
+        for (const auto& part : parts){
+            PreparedPart pp;
+            pp.vertices = part.vertices.data();
+            pp.vertexCount = part.vertices.size();
+            pp.indices = part.indices.data();
+            pp.indexCount = part.indices.size();
+            pp.material = part.material;
+            pp.lods = part.lods;
+            pp.bounds = part.bounds;
+            out.parts.push_back(std::move(pp));
+        }
+    }
+
+    // BVH для выбора лучом - по полному разрешению (первый уровень детализации)
+    for (auto& pp : out.parts){
+        const size_t first = pp.lods.empty() ? 0 : pp.lods[0].indexOffset;
+        const size_t count = pp.lods.empty() ? pp.indexCount : pp.lods[0].indexCount;
+        pp.bvh.build(pp.vertices, pp.vertexCount, pp.indices + first, count);
+    }
+
+    if (desc.loadMaps){
+        std::unordered_map<QString, BakedTextureHandle> loaded;
+        for (auto& pp : out.parts) loadMaps(desc, pp, loaded);
+    }
+}
+
+} // namespace
+
+ModelHandle ModelCache::acquire(const ModelDesc& desc)
+{
+    const QString key = makeKey(desc);
+    auto it = m_models.find(key);
+    if (it != m_models.end()) return it->second;
+
+    // Модель становится резидентной, когда GL-поток выполнит все ее выгрузки;
+    // до этого объекты ее не рисуют
+    auto model = std::make_shared<Model>();
+    m_models.emplace(key, model);
+
+    AssetLoader::instance().run([model, desc, key](){
+        auto data = std::make_shared<PreparedModel>();
+        prepare(desc, key, *data);
+
+        // Каждая часть выгружается отдельно, чтобы не превышать бюджет кадра
+        for (size_t k = 0; k < data->parts.size(); ++k){
+            AssetLoader::instance().post([model, data, k](QOpenGLFunctions_3_3_Core* f){
+                PreparedPart& src = data->parts[k];
+
+                auto uploadMap = [&](const PreparedPart::Map& map) -> TextureHandle {
+                    if (map.desc.path.isEmpty()) return nullptr;
+                    return TextureRegistry::instance().acquire(f, map.desc, map.baked);
+                };
+
+                Model::Part mp;
+                mp.material = src.material;
+                mp.mapKd = uploadMap(src.mapKd);
+                mp.mapKs = uploadMap(src.mapKs);
+                mp.mapKn = uploadMap(src.mapKn);
+                mp.mesh.upload(f, src.vertices, src.vertexCount, src.indices, src.indexCount, Mesh::Layout::Quantized);
+                mp.mesh.setLods(src.lods);
+                mp.bvh = std::move(src.bvh);
+
+                if (model->lodErrors.size() < src.lods.size()) model->lodErrors.resize(src.lods.size(), 0.0f);
+                for (size_t l = 0; l < src.lods.size(); ++l){
+                    model->lodErrors[l] = std::max(model->lodErrors[l], src.lods[l].error);
+                }
+                model->bounds.merge(src.bounds);
+                model->parts.push_back(std::move(mp));
+            });
+        }
+        AssetLoader::instance().post([model](QOpenGLFunctions_3_3_Core*){
+            model->resident = true;
+        });
+    });
+
+    return model;
+}
+
+void ModelCache::release(QOpenGLFunctions_3_3_Core* f, Model& model)
+{
+    for (auto& p : model.parts){
+        p.mesh.release(f);
+    }
+}
+
+void ModelCache::purge(QOpenGLFunctions_3_3_Core* f)
+{
+    for (auto it = m_models.begin(); it != m_models.end(); ){
+        // Единственная оставшаяся ссылка принадлежит самому кешу
+        if (it->second.use_count() == 1){
+            release(f, *it->second);
+            it = m_models.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef MODELCACHE_H
+#define MODELCACHE_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QString>
+
+#include "mesh.h"
+#include "objloader.h"
+#include "textureregistry.h"
+#include "trianglebvh.h"
+
+// Общий для процесса кеш моделей: каждый OBJ разбирается и загружается в GPU один раз,
+// экземпляры объектов получают разделяемые дескрипторы со счетчиком ссылок.
+// Разбор и декодирование текстур выполняются в фоне (AssetLoader)
+
+struct ModelDesc
+{
+    QString path;
+    float targetSize = 1.0f;  // Максимальный размер после нормализации (в мировых единицах)
+    bool rotXNeg90 = false;   // Поворот вокруг X на -90 градусов
+    bool rotY180   = false;   // Поворот вокруг Y на 180 градусов
+    bool loadMaps  = false;   // Загружать ли текстуры map_Kd/map_Ks/map_Kn из MTL
+};
+
+class Model
+{
+public:
+    struct Part {
+        Mesh mesh;
+        ObjLoader::Material material;
+
+        // nullptr, если карты нет в MTL или загрузка текстур не запрашивалась
+        TextureHandle mapKd;
+        TextureHandle mapKs;
+        TextureHandle mapKn;
+
+        // Треугольники первого уровня детализации для выбора лучом (координаты модели)
+        TriangleBvh bvh;
+    };
+
+    std::vector<Part> parts;
+    bool resident = false; // Все части выгружены в GPU, модель можно рисовать
+    Bounds bounds;         // Объединение границ частей (единицы модели)
+
+    // Ошибка каждого уровня детализации (максимум по частям, единицы модели)
+    std::vector<float> lodErrors;
+
+    // Допустимая ошибка упрощения на экране
+    static constexpr float kLodPixelError = 1.0f;
+
+    // Самый грубый уровень, ошибка которого на экране не превышает kLodPixelError;
+    // pixelsPerUnit - размер единицы модели в пикселях на расстоянии объекта
+    int selectLod(float pixelsPerUnit) const;
+
+    // Ближайшее пересечение луча в координатах модели с треугольниками частей
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const;
+};
+
+using ModelHandle = std::shared_ptr<const Model>;
+
+class ModelCache
+{
+public:
+    static ModelCache& instance();
+
+    // Возвращает модель из кеша либо ставит ее в фоновую загрузку;
+    // выгрузка в GPU выполняется в AssetLoader::pump
+    ModelHandle acquire(const ModelDesc& desc);
+
+    // Освобождение GPU-ресурсов моделей, на которые больше никто не ссылается
+    void purge(QOpenGLFunctions_3_3_Core* f);
+
+    int size() const { return (int)m_models.size(); }
+
+private:
+    ModelCache() = default;
+
+    static QString makeKey(const ModelDesc& desc);
+    static void release(QOpenGLFunctions_3_3_Core* f, Model& model);
+
+    std::unordered_map<QString, std::shared_ptr<Model>> m_models;
+};
+
+#endif // MODELCACHE_H
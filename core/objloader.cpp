@@ -1,25 +1,110 @@
 #include "objloader.h"
 
 #include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <thread>
 #include <unordered_map>
 
 #include <QDir>
-#include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
-#include <QRegularExpression>
 
-struct Idx { int v=-1, t=-1, n=-1; };
+#include "mappedfile.h"
+#include "vertexmap.h"
 
-static bool parseIdx(const QString& token, Idx& idx)
+// Разбор OBJ/MTL выполняется прямо по байтам отображенного в память файла:
+// токены - это пары указателей внутри буфера, числа читаются через std::from_chars,
+// поэтому на строку не создается ни QString, ни QStringList
+
+struct Token
+{
+    const char* p = nullptr;
+    const char* e = nullptr;
+
+    bool empty() const { return p == e; }
+    bool is(const char* s) const {
+        const char* q = p;
+        while (q != e && *s && *q == *s){ ++q; ++s; }
+        return q == e && *s == 0;
+    }
+    QString toString() const { return QString::fromUtf8(p, int(e - p)); }
+};
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Следующая строка буфера [lineBegin, lineEnd) без символа перевода строки
+static bool nextLine(const char*& cur, const char* end, const char*& lineBegin, const char*& lineEnd)
+{
+    if (cur >= end) return false;
+    lineBegin = cur;
+    while (cur < end && *cur != '\n') ++cur;
+    lineEnd = cur;
+    if (cur < end) ++cur; // Пропуск '\n'
+    return true;
+}
+
+static bool nextToken(const char*& cur, const char* end, Token& t)
+{
+    while (cur < end && isBlank(*cur)) ++cur;
+    if (cur >= end) return false;
+    t.p = cur;
+    while (cur < end && !isBlank(*cur)) ++cur;
+    t.e = cur;
+    return true;
+}
+
+static float toFloat(const Token& t)
 {
-    // Форматы индексов: v, v/t, v//n, v/t/n (индексация в OBJ начинается с 1)
-    QStringList parts = token.split('/');
-    if (parts.size() < 1) return false;
+    const char* p = t.p;
+    if (p != t.e && *p == '+') ++p; // from_chars не принимает явный '+'
+    float v = 0.0f;
+    std::from_chars(p, t.e, v);
+    return v;
+}
+
+static int toInt(const char* p, const char* e)
+{
+    if (p != e && *p == '+') ++p;
+    int v = 0;
+    std::from_chars(p, e, v);
+    return v;
+}
 
-    idx.v = parts[0].toInt() - 1;
-    if (parts.size() >= 2 && !parts[1].isEmpty()) idx.t = parts[1].toInt() - 1;
-    if (parts.size() >= 3 && !parts[2].isEmpty()) idx.n = parts[2].toInt() - 1;
+static bool readVec3(const char*& cur, const char* end, Vec3& out)
+{
+    Token a, b, c;
+    if (!nextToken(cur, end, a) || !nextToken(cur, end, b) || !nextToken(cur, end, c)) return false;
+    out = {toFloat(a), toFloat(b), toFloat(c)};
+    return true;
+}
+
+// Индексы вершины грани в том виде, как они записаны в файле:
+// > 0 - номер с единицы, < 0 - смещение от конца уже прочитанных данных, 0 - индекс отсутствует
+struct Idx { int v=0, t=0, n=0; };
+
+static bool parseIdx(const Token& token, Idx& idx)
+{
+    // Форматы индексов: v, v/t, v//n, v/t/n
+    if (token.empty()) return false;
+
+    const char* fields[3] = {token.p, nullptr, nullptr};
+    const char* ends[3]   = {token.e, nullptr, nullptr};
+    int count = 1;
+    for (const char* q = token.p; q != token.e; ++q){
+        if (*q != '/') continue;
+        ends[count-1] = q;
+        if (count == 3) break;
+        fields[count] = q + 1;
+        ends[count] = token.e;
+        ++count;
+    }
+
+    idx.v = toInt(fields[0], ends[0]);
+    if (count >= 2 && fields[1] != ends[1]) idx.t = toInt(fields[1], ends[1]);
+    if (count >= 3 && fields[2] != ends[2]) idx.n = toInt(fields[2], ends[2]);
     return true;
 }
 
@@ -45,58 +130,50 @@ static QString resolveSiblingPath(const QString& baseObjPath, const QString& fil
 
 static bool loadMtlFile(const QString& mtlPath, std::unordered_map<QString, ObjLoader::Material>& outMats)
 {
-    QFile f(mtlPath);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
-    QTextStream in(&f);
+    MappedFile file;
+    if (!file.open(mtlPath)) return false;
 
     ObjLoader::Material cur;
     bool has = false;
 
-    while (!in.atEnd()){
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith("#")) continue;
+    const char* cursor = file.data();
+    const char* lb = nullptr;
+    const char* le = nullptr;
+    while (nextLine(cursor, file.end(), lb, le)){
+        Token key;
+        if (!nextToken(lb, le, key) || *key.p == '#') continue;
 
-        auto parts = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-        if (parts.isEmpty()) continue;
-
-        const QString key = parts[0];
-
-        if (key == "newmtl" && parts.size() >= 2){
+        Token arg;
+        if (key.is("newmtl") && nextToken(lb, le, arg)){
             if (has) outMats[cur.name] = cur;
             cur = ObjLoader::Material{};
-            cur.name = parts[1];
-            cur.ka = {0,0,0};
-            cur.kd = {1,1,1};
-            cur.ks = {0,0,0};
-            cur.ns = 16.0f;
-            cur.d = 1.0f;
-            cur.illum = 2;
-            cur.mapKd.clear();
-            cur.mapKs.clear();
-            cur.mapKn.clear();
-            cur.useTexture = false;
+            cur.name = arg.toString();
             has = true;
-        } else if (key == "Kd" && parts.size() >= 4 && has){
-            cur.kd = {parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat()};
-        } else if (key == "Ka" && parts.size() >= 4 && has){
-            cur.ka = {parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat()};
-        } else if (key == "Ks" && parts.size() >= 4 && has){
-            cur.ks = {parts[1].toFloat(), parts[2].toFloat(), parts[3].toFloat()};
-        } else if (key == "Ns" && parts.size() >= 2 && has){
-            cur.ns = parts[1].toFloat();
-        } else if (key == "d" && parts.size() >= 2 && has){
-            cur.d = parts[1].toFloat();
-        } else if (key == "Tr" && parts.size() >= 2 && has){
-            cur.d = 1.0f - parts[1].toFloat();
-        } else if (key == "illum" && parts.size() >= 2 && has){
-            cur.illum = parts[1].toInt();
-        } else if (key == "map_Kd" && parts.size() >= 2 && has){
-            cur.mapKd = parts[1];
+            continue;
+        }
+        if (!has) continue;
+
+        if (key.is("Kd")){
+            readVec3(lb, le, cur.kd);
+        } else if (key.is("Ka")){
+            readVec3(lb, le, cur.ka);
+        } else if (key.is("Ks")){
+            readVec3(lb, le, cur.ks);
+        } else if (key.is("Ns") && nextToken(lb, le, arg)){
+            cur.ns = toFloat(arg);
+        } else if (key.is("d") && nextToken(lb, le, arg)){
+            cur.d = toFloat(arg);
+        } else if (key.is("Tr") && nextToken(lb, le, arg)){
+            cur.d = 1.0f - toFloat(arg);
+        } else if (key.is("illum") && nextToken(lb, le, arg)){
+            cur.illum = toInt(arg.p, arg.e);
+        } else if (key.is("map_Kd") && nextToken(lb, le, arg)){
+            cur.mapKd = arg.toString();
             cur.useTexture = true;
-        } else if (key == "map_Ks" && parts.size() >= 2 && has){
-            cur.mapKs = parts[1];
-        } else if ((key == "map_Kn" || key == "map_Bump" || key == "bump") && parts.size() >= 2 && has){
-            cur.mapKn = parts[1];
+        } else if (key.is("map_Ks") && nextToken(lb, le, arg)){
+            cur.mapKs = arg.toString();
+        } else if ((key.is("map_Kn") || key.is("map_Bump") || key.is("bump")) && nextToken(lb, le, arg)){
+            cur.mapKn = arg.toString();
         }
     }
 
@@ -104,127 +181,359 @@ static bool loadMtlFile(const QString& mtlPath, std::unordered_map<QString, ObjL
     return !outMats.empty();
 }
 
-bool ObjLoader::loadParts(const QString& path, std::vector<ObjPart>& partsOut, QString* err)
+// Параллельный разбор OBJ по чанкам:
+// 1) файл делится на диапазоны байт по границам строк, каждый поток разбирает свой диапазон
+//    (v/vn/vt/f/usemtl/mtllib), индексы граней сохраняются без разрешения;
+// 2) после подсчета префиксных сумм числа v/vt/vn индексы приводятся к глобальным
+//    (в т.ч. отрицательные относительные), каждый чанк раскладывает грани по материалам
+//    и дедуплицирует вершины внутри себя;
+// 3) корзины одного материала сливаются в порядке чанков с дедупликацией между чанками.
+// Маленькие файлы разбираются одним чанком в текущем потоке.
+
+namespace {
+
+const qint64 kMinChunkBytes = 4 * 1024 * 1024;
+
+// Вершина грани после фазы 1: индекс либо глобальный (rel = 0),
+// либо отсчитывается от начала чанка (rel = 1, для отрицательных индексов OBJ)
+struct Corner
 {
-    partsOut.clear();
+    int v = -1, t = -1, n = -1;
+    unsigned char relV = 0, relT = 0, relN = 0;
+};
 
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)){
-        if (err) *err = "Cannot open OBJ: " + path;
-        return false;
-    }
-    QTextStream in(&file);
+struct Bucket
+{
+    std::vector<Vertex> v;
+    std::vector<unsigned> ind;
+    std::vector<VertexKey> keys; // Ключ (v,t,n) каждой вершины - для слияния чанков
+    VertexMap remap;
+    ObjLoader::Material mat;
+};
+
+struct Chunk
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
 
+    // Фаза 1
     std::vector<Vec3> pos;
     std::vector<Vec3> nrm;
     std::vector<Vec2> uv;
+    std::vector<Corner> corners;
+    std::vector<unsigned> faceSizes;
+    struct Switch { size_t face; Token name; };
+    std::vector<Switch> switches; // usemtl: номер первой грани, к которой он относится
+    std::vector<Token> mtllibs;
+
+    // Фаза 2
+    size_t posBase = 0, uvBase = 0, nrmBase = 0;
+    ObjLoader::Material startMat;
+    std::vector<ObjLoader::Material> switchMats;
+    std::vector<Bucket> buckets;
+};
+
+// Выполнение fn(0..count-1) не более чем в threads потоках
+template <typename Fn>
+void parallelFor(size_t count, size_t threads, Fn fn)
+{
+    threads = std::min(threads, count);
+    if (threads <= 1){
+        for (size_t k = 0; k < count; ++k) fn(k);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (size_t t = 0; t < threads; ++t){
+        pool.emplace_back([&](){
+            for (size_t k = next++; k < count; k = next++) fn(k);
+        });
+    }
+    for (auto& th : pool) th.join();
+}
 
-    std::unordered_map<QString, Material> mats;
-    Material currentMat;
-    currentMat.name = "default";
-    currentMat.kd = {1,1,1};
+void parseChunk(Chunk& c)
+{
+    // Отрицательный индекс ссылается на данные, прочитанные до текущей строки;
+    // пока база чанка неизвестна, он сохраняется относительно начала чанка
+    auto resolve = [](int raw, size_t localCount, int& out, unsigned char& rel){
+        if (raw > 0){ out = raw - 1; rel = 0; }
+        else if (raw < 0){ out = int(localCount) + raw; rel = 1; }
+        else { out = -1; rel = 0; }
+    };
+
+    const char* cursor = c.begin;
+    const char* lb = nullptr;
+    const char* le = nullptr;
+    while (nextLine(cursor, c.end, lb, le)){
+        Token key;
+        if (!nextToken(lb, le, key) || *key.p == '#') continue;
+
+        if (key.is("v")){
+            Vec3 p;
+            if (readVec3(lb, le, p)) c.pos.push_back(p);
+        } else if (key.is("vn")){
+            Vec3 n;
+            if (readVec3(lb, le, n)) c.nrm.push_back(n);
+        } else if (key.is("vt")){
+            Token a, b;
+            if (nextToken(lb, le, a) && nextToken(lb, le, b)) c.uv.push_back({toFloat(a), toFloat(b)});
+        } else if (key.is("f")){
+            const size_t first = c.corners.size();
+            Token tok;
+            while (nextToken(lb, le, tok)){
+                Idx idx;
+                parseIdx(tok, idx);
+                Corner cr;
+                resolve(idx.v, c.pos.size(), cr.v, cr.relV);
+                resolve(idx.t, c.uv.size(),  cr.t, cr.relT);
+                resolve(idx.n, c.nrm.size(), cr.n, cr.relN);
+                c.corners.push_back(cr);
+            }
+            // Не менее трех вершин в грани
+            const size_t count = c.corners.size() - first;
+            if (count < 3) c.corners.resize(first);
+            else c.faceSizes.push_back(unsigned(count));
+        } else if (key.is("mtllib")){
+            Token name;
+            while (nextToken(lb, le, name)) c.mtllibs.push_back(name);
+        } else if (key.is("usemtl")){
+            Token name;
+            if (nextToken(lb, le, name)) c.switches.push_back({c.faceSizes.size(), name});
+        }
+    }
+}
 
-    struct Tmp
+void bucketChunk(Chunk& c, const std::vector<Vec3>& pos, const std::vector<Vec2>& uv, const std::vector<Vec3>& nrm)
+{
+    // Число вершин граней по материалам - для начального размера таблиц дедупликации
+    std::unordered_map<QString, size_t> cornersByName;
     {
-        std::vector<Vertex> v;
-        std::vector<unsigned> ind;
-        std::unordered_map<long long, unsigned> remap;
-        Material mat;
-    };
-    std::unordered_map<QString, Tmp> buckets;
-
-    auto getBucket = [&](const Material& m)->Tmp&{
-        auto it = buckets.find(m.name);
-        if (it == buckets.end()){
-            Tmp t;
-            t.mat = m;
-            auto res = buckets.emplace(m.name, std::move(t));
-            return res.first->second;
+        size_t sw = 0;
+        const QString* name = &c.startMat.name;
+        size_t* count = &cornersByName[*name];
+        for (size_t face = 0; face < c.faceSizes.size(); ++face){
+            if (sw < c.switches.size() && c.switches[sw].face == face){
+                while (sw < c.switches.size() && c.switches[sw].face == face) name = &c.switchMats[sw++].name;
+                count = &cornersByName[*name];
+            }
+            *count += c.faceSizes[face];
         }
-        return it->second;
+    }
+
+    // Уникальных вершин не больше числа вершин граней и примерно столько,
+    // сколько атрибутов самого многочисленного типа приходится на эту долю граней
+    const size_t maxAttr = std::max(c.pos.size(), std::max(c.uv.size(), c.nrm.size()));
+    auto expectedUnique = [&](size_t corners){
+        if (c.corners.empty()) return corners;
+        return std::min(corners, size_t(double(maxAttr) * corners / c.corners.size()) + 1);
     };
 
-    auto makeKey = [](int vi, int ti, int ni)->long long {
-        long long a = (long long)(vi + 1);
-        long long b = (long long)(ti + 1);
-        long long c = (long long)(ni + 1);
-        return (a << 42) ^ (b << 21) ^ c;
+    std::unordered_map<QString, size_t> byName;
+    Bucket* bucket = nullptr;
+    const ObjLoader::Material* mat = &c.startMat;
+
+    auto addVertex = [&](const Corner& cr)->unsigned{
+        const int vi = cr.relV ? cr.v + int(c.posBase) : cr.v;
+        const int ti = cr.relT ? cr.t + int(c.uvBase)  : cr.t;
+        const int ni = cr.relN ? cr.n + int(c.nrmBase) : cr.n;
+
+        const VertexKey key = makeKey(vi, ti, ni);
+        bool inserted = false;
+        const unsigned outIdx = bucket->remap.insert(key, (unsigned)bucket->v.size(), inserted);
+        if (!inserted) return outIdx;
+
+        Vertex vx{};
+        vx.pos = (vi >= 0 && vi < (int)pos.size()) ? pos[vi] : Vec3{0,0,0};
+        vx.uv  = (ti >= 0 && ti < (int)uv.size())  ? uv[ti]  : Vec2{0,0};
+        vx.nrm = (ni >= 0 && ni < (int)nrm.size()) ? nrm[ni] : Vec3{0,1,0};
+
+        bucket->v.push_back(vx);
+        bucket->keys.push_back(key);
+        return outIdx;
     };
 
-    while (!in.atEnd()){
-        QString line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith("#")) continue;
+    size_t sw = 0;
+    size_t corner = 0;
+    for (size_t face = 0; face < c.faceSizes.size(); ++face){
+        while (sw < c.switches.size() && c.switches[sw].face == face){
+            mat = &c.switchMats[sw++];
+            bucket = nullptr;
+        }
+        if (!bucket){
+            auto it = byName.find(mat->name);
+            if (it == byName.end()){
+                it = byName.emplace(mat->name, c.buckets.size()).first;
+                c.buckets.emplace_back();
+                Bucket& b = c.buckets.back();
+                b.mat = *mat;
+                const size_t expected = expectedUnique(cornersByName[mat->name]);
+                b.remap.reserve(expected);
+                b.v.reserve(expected);
+                b.keys.reserve(expected);
+            }
+            bucket = &c.buckets[it->second];
+        }
+
+        // Веерная триангуляция полигона
+        const Corner* fc = &c.corners[corner];
+        const unsigned n = c.faceSizes[face];
+        unsigned v0 = addVertex(fc[0]);
+        unsigned v1 = addVertex(fc[1]);
+        for (unsigned k = 2; k < n; ++k){
+            unsigned v2 = addVertex(fc[k]);
+            bucket->ind.push_back(v0);
+            bucket->ind.push_back(v1);
+            bucket->ind.push_back(v2);
+            v1 = v2;
+        }
+        corner += n;
+    }
+}
+
+// Слияние корзин одного материала из разных чанков (в порядке чанков)
+Bucket mergeBuckets(std::vector<Bucket*>& parts)
+{
+    if (parts.size() == 1) return std::move(*parts[0]);
+
+    Bucket out;
+    out.mat = parts[0]->mat;
+
+    size_t total = 0;
+    for (auto* b : parts) total += b->v.size();
+    out.remap.reserve(total);
+
+    std::vector<unsigned> local;
+    for (auto* b : parts){
+        local.resize(b->v.size());
+        for (size_t k = 0; k < b->v.size(); ++k){
+            bool inserted = false;
+            local[k] = out.remap.insert(b->keys[k], (unsigned)out.v.size(), inserted);
+            if (inserted) out.v.push_back(b->v[k]);
+        }
+        out.ind.reserve(out.ind.size() + b->ind.size());
+        for (unsigned idx : b->ind) out.ind.push_back(local[idx]);
+
+        // Освобождение памяти чанка по мере слияния
+        *b = Bucket{};
+    }
+    return out;
+}
 
-        auto p = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-        if (p.isEmpty()) continue;
+} // namespace
 
-        if (p[0] == "mtllib" && p.size() >= 2){
+bool ObjLoader::loadParts(const QString& path, std::vector<ObjPart>& partsOut, QString* err)
+{
+    partsOut.clear();
 
-    for (int mi = 1; mi < p.size(); ++mi){
-        QString mtlPath = resolveSiblingPath(path, p[mi]);
-        loadMtlFile(mtlPath, mats);
+    MappedFile file;
+    if (!file.open(path)){
+        if (err) *err = "Cannot open OBJ: " + path;
+        return false;
+    }
+
+    // Деление на чанки по границам строк
+    const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(hw, size_t(file.size() / kMinChunkBytes)));
+
+    std::vector<Chunk> chunks(chunkCount);
+    {
+        const char* b = file.data();
+        const char* e = file.end();
+        const size_t step = size_t(file.size()) / chunkCount;
+        for (size_t k = 0; k < chunkCount; ++k){
+            const char* ce = (k + 1 == chunkCount) ? e : std::min(e, b + step);
+            while (ce < e && ce[-1] != '\n') ++ce;
+            chunks[k].begin = b;
+            chunks[k].end = ce;
+            b = ce;
+        }
     }
-} else if (p[0] == "usemtl" && p.size() >= 2){
-            QString name = p[1];
-            auto it = mats.find(name);
+
+    // Фаза 1: разбор строк
+    parallelFor(chunks.size(), hw, [&](size_t k){ parseChunk(chunks[k]); });
+
+    // Материалы и глобальные массивы атрибутов
+    std::unordered_map<QString, Material> mats;
+    for (auto& c : chunks){
+        for (const Token& name : c.mtllibs){
+            loadMtlFile(resolveSiblingPath(path, name.toString()), mats);
+        }
+    }
+
+    std::vector<Vec3> pos;
+    std::vector<Vec3> nrm;
+    std::vector<Vec2> uv;
+    {
+        size_t np = 0, nt = 0, nn = 0;
+        for (auto& c : chunks){
+            c.posBase = np; np += c.pos.size();
+            c.uvBase  = nt; nt += c.uv.size();
+            c.nrmBase = nn; nn += c.nrm.size();
+        }
+        pos.reserve(np);
+        uv.reserve(nt);
+        nrm.reserve(nn);
+        for (auto& c : chunks){
+            pos.insert(pos.end(), c.pos.begin(), c.pos.end());
+            uv.insert(uv.end(), c.uv.begin(), c.uv.end());
+            nrm.insert(nrm.end(), c.nrm.begin(), c.nrm.end());
+            std::vector<Vec3>().swap(c.pos);
+            std::vector<Vec2>().swap(c.uv);
+            std::vector<Vec3>().swap(c.nrm);
+        }
+    }
+
+    // Состояние usemtl передается между чанками последовательно
+    Material currentMat;
+    currentMat.name = "default";
+    currentMat.kd = {1,1,1};
+    for (auto& c : chunks){
+        c.startMat = currentMat;
+        c.switchMats.reserve(c.switches.size());
+        for (const auto& sw : c.switches){
+            QString matName = sw.name.toString();
+            auto it = mats.find(matName);
             if (it != mats.end()){
                 currentMat = it->second;
             } else {
-                currentMat.name = name;
+                currentMat.name = matName;
                 currentMat.kd = {1,1,1};
                 currentMat.mapKd.clear();
             }
-        } else if (p[0] == "v" && p.size() >= 4){
-            pos.push_back({p[1].toFloat(), p[2].toFloat(), p[3].toFloat()});
-        } else if (p[0] == "vn" && p.size() >= 4){
-            nrm.push_back({p[1].toFloat(), p[2].toFloat(), p[3].toFloat()});
-        } else if (p[0] == "vt" && p.size() >= 3){
-            uv.push_back({p[1].toFloat(), p[2].toFloat()});
-        } else if (p[0] == "f" && p.size() >= 4){
-            Tmp& bucket = getBucket(currentMat);
-
-            auto addVertex = [&](const QString& tok)->unsigned{
-                Idx idx;
-                parseIdx(tok, idx);
+            c.switchMats.push_back(currentMat);
+        }
+    }
 
-                auto fix = [](int i, int count)->int { return (i < 0) ? (count + i) : i; };
-                int vi = fix(idx.v, (int)pos.size());
-                int ti = (idx.t == -1) ? -1 : fix(idx.t, (int)uv.size());
-                int ni = (idx.n == -1) ? -1 : fix(idx.n, (int)nrm.size());
-
-                long long key = makeKey(vi, ti, ni);
-                auto it = bucket.remap.find(key);
-                if (it != bucket.remap.end()) return it->second;
-
-                Vertex vx{};
-                vx.pos = (vi >= 0 && vi < (int)pos.size()) ? pos[vi] : Vec3{0,0,0};
-                vx.uv  = (ti >= 0 && ti < (int)uv.size())  ? uv[ti]  : Vec2{0,0};
-                vx.nrm = (ni >= 0 && ni < (int)nrm.size()) ? nrm[ni] : Vec3{0,1,0};
-
-                unsigned outIdx = (unsigned)bucket.v.size();
-                bucket.v.push_back(vx);
-                bucket.remap[key] = outIdx;
-                return outIdx;
-            };
-
-            // Веерная триангуляция полигона
-            unsigned v0 = addVertex(p[1]);
-            for (int k=2; k < p.size()-1; ++k){
-                unsigned v1 = addVertex(p[k]);
-                unsigned v2 = addVertex(p[k+1]);
-                bucket.ind.push_back(v0);
-                bucket.ind.push_back(v1);
-                bucket.ind.push_back(v2);
-            }
+    // Фаза 2: разрешение индексов и дедупликация внутри чанков
+    parallelFor(chunks.size(), hw, [&](size_t k){
+        Chunk& c = chunks[k];
+        bucketChunk(c, pos, uv, nrm);
+        std::vector<Corner>().swap(c.corners);
+    });
+
+    // Фаза 3: слияние корзин по материалам
+    std::vector<QString> names;
+    std::unordered_map<QString, std::vector<Bucket*>> byMaterial;
+    for (auto& c : chunks){
+        for (auto& b : c.buckets){
+            auto& list = byMaterial[b.mat.name];
+            if (list.empty()) names.push_back(b.mat.name);
+            list.push_back(&b);
         }
     }
 
-    for (auto& kv : buckets){
-        if (kv.second.v.empty() || kv.second.ind.empty()) continue;
+    std::vector<Bucket> buckets(names.size());
+    parallelFor(names.size(), hw, [&](size_t k){ buckets[k] = mergeBuckets(byMaterial[names[k]]); });
+
+    for (auto& b : buckets){
+        if (b.v.empty() || b.ind.empty()) continue;
         ObjPart part;
-        part.vertices = std::move(kv.second.v);
-        part.indices  = std::move(kv.second.ind);
-        part.material = kv.second.mat;
+        part.vertices = std::move(b.v);
+        part.indices  = std::move(b.ind);
+        part.material = b.mat;
+        part.bounds = Bounds::fromPositions(part.vertices.data(), part.vertices.size());
         partsOut.push_back(std::move(part));
     }
 
@@ -241,6 +550,25 @@ bool ObjLoader::loadParts(const QString& path, std::vector<ObjPart>& partsOut, Q
     return true;
 }
 
+std::vector<QString> ObjLoader::materialLibraries(const QString& path)
+{
+    std::vector<QString> out;
+
+    MappedFile file;
+    if (!file.open(path)) return out;
+
+    const char* cursor = file.data();
+    const char* lb = nullptr;
+    const char* le = nullptr;
+    while (nextLine(cursor, file.end(), lb, le)){
+        Token key;
+        if (!nextToken(lb, le, key) || !key.is("mtllib")) continue;
+        Token name;
+        while (nextToken(lb, le, name)) out.push_back(resolveSiblingPath(path, name.toString()));
+    }
+    return out;
+}
+
 bool ObjLoader::load(const QString& path, std::vector<Vertex>& outV, std::vector<unsigned>& outI, QString* err)
 {
     outV.clear();
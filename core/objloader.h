@@ -32,6 +32,13 @@ public:
         std::vector<Vertex> vertices;
         std::vector<unsigned> indices;
         Material material;
+
+        // Уровни детализации - диапазоны indices (заполняются при предобработке модели);
+        // пусто - один уровень на весь буфер
+        std::vector<MeshLod> lods;
+
+        // Границы вершин части (заполняются при разборе и пересчитываются после предобработки)
+        Bounds bounds;
     };
 
     // Загрузка полной сетки
@@ -39,6 +46,9 @@ public:
 
     // Загрузка модели с разбиением по материалам
     static bool loadParts(const QString& path, std::vector<ObjPart>& parts, QString* err = nullptr);
+
+    // Пути MTL файлов, на которые ссылается OBJ (mtllib), без разбора геометрии
+    static std::vector<QString> materialLibraries(const QString& path);
 };
 
 #endif // OBJLOADER_H
@@ -0,0 +1,142 @@
+#include "programcache.h"
+
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "mappedfile.h"
+
+namespace {
+
+const char kMagic[4] = {'L','H','P','B'};
+const quint32 kVersion = 1;
+const int kKeySize = 16; // MD5
+
+struct Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 binaryFormat;
+    quint32 length;
+    quint8 key[kKeySize];
+};
+
+QOpenGLExtraFunctions* extraFunctions()
+{
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    return ctx ? ctx->extraFunctions() : nullptr;
+}
+
+} // namespace
+
+bool ProgramCache::isSupported(QOpenGLFunctions_3_3_Core* f)
+{
+    const QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    if (!ctx || !ctx->hasExtension("GL_ARB_get_program_binary")) return false;
+
+    // Драйвер может поддерживать расширение, но не предлагать ни одного формата
+    int formats = 0;
+    f->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+QByteArray ProgramCache::key(QOpenGLFunctions_3_3_Core* f, const char* vsSrc, const char* fsSrc)
+{
+    QCryptographicHash h(QCryptographicHash::Md5);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}){
+        const char* str = reinterpret_cast<const char*>(f->glGetString(name));
+        if (str) h.addData(QByteArrayView(str));
+        h.addData(QByteArrayView("|"));
+    }
+    h.addData(QByteArrayView(vsSrc));
+    h.addData(QByteArrayView("|"));
+    h.addData(QByteArrayView(fsSrc));
+    return h.result();
+}
+
+QString ProgramCache::cacheFilePath(const QByteArray& key)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shaders";
+    const QByteArray name = key.toHex();
+    return dir + "/" + QString::fromLatin1(name.constData(), name.size()) + ".lhpb";
+}
+
+unsigned ProgramCache::load(QOpenGLFunctions_3_3_Core* f, const QByteArray& key)
+{
+    QOpenGLExtraFunctions* ext = extraFunctions();
+    if (!ext || key.size() != kKeySize) return 0;
+
+    MappedFile file;
+    if (!file.open(cacheFilePath(key))) return 0;
+
+    const quint64 size = quint64(file.size());
+    if (size < sizeof(Header)) return 0;
+    Header hdr;
+    std::memcpy(&hdr, file.data(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, kMagic, 4) != 0 || hdr.version != kVersion) return 0;
+    if (std::memcmp(hdr.key, key.constData(), kKeySize) != 0) return 0;
+    if (hdr.length == 0 || sizeof(Header) + quint64(hdr.length) != size) return 0;
+
+    unsigned program = f->glCreateProgram();
+    ext->glProgramBinary(program, hdr.binaryFormat, file.data() + sizeof(Header), int(hdr.length));
+
+    // После обновления драйвера образ может быть отвергнут - тогда сборка из исходников
+    int ok = 0;
+    f->glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok){
+        qDebug() << "ProgramCache: driver rejected cached program binary";
+        f->glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::prepare(unsigned program)
+{
+    if (QOpenGLExtraFunctions* ext = extraFunctions()){
+        ext->glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramCache::store(QOpenGLFunctions_3_3_Core* f, unsigned program, const QByteArray& key)
+{
+    QOpenGLExtraFunctions* ext = extraFunctions();
+    if (!ext || key.size() != kKeySize) return false;
+
+    int length = 0;
+    f->glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return false;
+
+    QByteArray blob(int(sizeof(Header)) + length, 0);
+    GLenum format = 0;
+    int written = 0;
+    ext->glGetProgramBinary(program, length, &written, &format, blob.data() + sizeof(Header));
+    if (written <= 0) return false;
+    blob.resize(int(sizeof(Header)) + written);
+
+    Header hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, kMagic, 4);
+    hdr.version = kVersion;
+    hdr.binaryFormat = format;
+    hdr.length = quint32(written);
+    std::memcpy(hdr.key, key.constData(), kKeySize);
+    std::memcpy(blob.data(), &hdr, sizeof(hdr));
+
+    const QString file = cacheFilePath(key);
+    QDir().mkpath(QFileInfo(file).dir().absolutePath());
+
+    // Запись через временный файл: недописанный образ никогда не окажется на месте готового
+    QSaveFile sf(file);
+    if (!sf.open(QIODevice::WriteOnly)) return false;
+    if (sf.write(blob) != blob.size()) return false;
+    return sf.commit();
+}
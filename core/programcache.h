@@ -0,0 +1,35 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+class QOpenGLFunctions_3_3_Core;
+
+// Кеш двоичных образов шейдерных программ (ARB_get_program_binary) в пользовательском
+// каталоге кеша. Ключ - хеш исходников (вместе с подставленными #define) и строк
+// GL_VENDOR/GL_RENDERER/GL_VERSION: образ пригоден только для того же драйвера.
+// Если драйвер отвергает образ, Shader собирает программу из исходников и обновляет кеш
+
+class ProgramCache
+{
+public:
+    // Поддерживает ли текущий контекст получение и загрузку образов программ
+    static bool isSupported(QOpenGLFunctions_3_3_Core* f);
+
+    static QByteArray key(QOpenGLFunctions_3_3_Core* f, const char* vsSrc, const char* fsSrc);
+
+    // Программа из кеша; 0, если образа нет или драйвер его не принял
+    static unsigned load(QOpenGLFunctions_3_3_Core* f, const QByteArray& key);
+
+    // Разрешение получить образ программы (вызывается до glLinkProgram)
+    static void prepare(unsigned program);
+
+    // Сохранение образа собранной программы
+    static bool store(QOpenGLFunctions_3_3_Core* f, unsigned program, const QByteArray& key);
+
+private:
+    static QString cacheFilePath(const QByteArray& key);
+};
+
+#endif // PROGRAMCACHE_H
@@ -1,6 +1,12 @@
 #include "shader.h"
 
+#include <algorithm>
+
 #include <QByteArray>
+#include <QDebug>
+
+#include "glstate.h"
+#include "programcache.h"
 
 Shader::~Shader() {}
 
@@ -26,6 +32,19 @@ unsigned Shader::compile(QOpenGLFunctions_3_3_Core* f, unsigned type, const char
 
 bool Shader::build(QOpenGLFunctions_3_3_Core* f, const char* vsSrc, const char* fsSrc, QString* log)
 {
+    m_uniforms.clear();
+
+    // Образ программы из кеша избавляет от компиляции и компоновки
+    const bool cached = ProgramCache::isSupported(f);
+    const QByteArray key = cached ? ProgramCache::key(f, vsSrc, fsSrc) : QByteArray();
+    if (cached){
+        m_program = ProgramCache::load(f, key);
+        if (m_program){
+            collectUniforms(f);
+            return true;
+        }
+    }
+
     unsigned vs = compile(f, GL_VERTEX_SHADER, vsSrc, log);
     if (!vs) return false;
     unsigned fs = compile(f, GL_FRAGMENT_SHADER, fsSrc, log);
@@ -34,6 +53,7 @@ bool Shader::build(QOpenGLFunctions_3_3_Core* f, const char* vsSrc, const char*
     m_program = f->glCreateProgram();
     f->glAttachShader(m_program, vs);
     f->glAttachShader(m_program, fs);
+    if (cached) ProgramCache::prepare(m_program);
     f->glLinkProgram(m_program);
 
     int ok = 0;
@@ -50,34 +70,122 @@ bool Shader::build(QOpenGLFunctions_3_3_Core* f, const char* vsSrc, const char*
 
     f->glDeleteShader(vs);
     f->glDeleteShader(fs);
+
+    if (ok){
+        collectUniforms(f);
+        if (cached) ProgramCache::store(f, m_program, key);
+    }
     return ok;
 }
 
 void Shader::use(QOpenGLFunctions_3_3_Core* f) const
 {
-    f->glUseProgram(m_program);
+    GLState::instance().useProgram(f, m_program);
+}
+
+void Shader::collectUniforms(QOpenGLFunctions_3_3_Core* f)
+{
+    int count = 0, maxLen = 0;
+    f->glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    f->glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLen);
+
+    // Заполнение не более половины, размер - степень двойки
+    size_t capacity = 16;
+    while (capacity < size_t(count) * 2) capacity *= 2;
+    m_uniforms.assign(capacity, UniformSlot());
+
+    QByteArray name(std::max(maxLen, 1), 0);
+    for (int k = 0; k < count; ++k){
+        int len = 0, size = 0;
+        GLenum type = 0;
+        f->glGetActiveUniform(m_program, k, maxLen, &len, &size, &type, name.data());
+        // Массив перечисляется как "name[0]"; обращение идет по имени без индекса
+        QByteArray base(name.constData(), len);
+        if (base.endsWith("[0]")) base.chop(3);
+
+        const int loc = f->glGetUniformLocation(m_program, name.constData());
+        if (loc < 0) continue; // Переменная из uniform-блока
+
+        const quint32 hash = UniformId(base.constData()).hash;
+        size_t i = hash & (capacity - 1);
+        while (m_uniforms[i].used && m_uniforms[i].hash != hash) i = (i + 1) & (capacity - 1);
+        if (m_uniforms[i].used){
+            qWarning() << "Shader: uniform name hash collision:" << base;
+            continue;
+        }
+        m_uniforms[i].hash = hash;
+        m_uniforms[i].location = loc;
+        m_uniforms[i].used = true;
+    }
 }
 
-void Shader::setMat4(QOpenGLFunctions_3_3_Core* f, const char* name, const float* v) const
+const Shader::UniformSlot* Shader::slot(UniformId id) const
 {
-    int loc = f->glGetUniformLocation(m_program, name);
+    if (m_uniforms.empty()) return nullptr;
+    const size_t mask = m_uniforms.size() - 1;
+    for (size_t i = id.hash & mask; m_uniforms[i].used; i = (i + 1) & mask){
+        if (m_uniforms[i].hash == id.hash) return &m_uniforms[i];
+    }
+    return nullptr;
+}
+
+int Shader::location(UniformId id) const
+{
+    const UniformSlot* s = slot(id);
+    return s ? s->location : -1;
+}
+
+bool Shader::bindUniformBlock(QOpenGLFunctions_3_3_Core* f, const char* blockName, unsigned binding) const
+{
+    const unsigned index = f->glGetUniformBlockIndex(m_program, blockName);
+    if (index == GL_INVALID_INDEX) return false;
+    f->glUniformBlockBinding(m_program, index, binding);
+    return true;
+}
+
+void Shader::setMat4(QOpenGLFunctions_3_3_Core* f, UniformId id, const float* v) const
+{
+    int loc = location(id);
     if (loc >= 0) f->glUniformMatrix4fv(loc, 1, GL_FALSE, v);
 }
 
-void Shader::setVec3(QOpenGLFunctions_3_3_Core* f, const char* name, float x, float y, float z) const
+void Shader::setVec2(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y) const
 {
-    int loc = f->glGetUniformLocation(m_program, name);
-    if (loc >= 0) f->glUniform3f(loc, x,y,z);
+    const float v[4] = {x, y, 0, 0};
+    if (const UniformSlot* s = slot(id)){
+        if (s->changed(v, 0)) f->glUniform2f(s->location, x,y);
+    }
 }
 
-void Shader::setFloat(QOpenGLFunctions_3_3_Core* f, const char* name, float v) const
+void Shader::setVec3(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y, float z) const
 {
-    int loc = f->glGetUniformLocation(m_program, name);
-    if (loc >= 0) f->glUniform1f(loc, v);
+    const float v[4] = {x, y, z, 0};
+    if (const UniformSlot* s = slot(id)){
+        if (s->changed(v, 0)) f->glUniform3f(s->location, x,y,z);
+    }
+}
+
+void Shader::setFloat(QOpenGLFunctions_3_3_Core* f, UniformId id, float v) const
+{
+    const float vv[4] = {v, 0, 0, 0};
+    if (const UniformSlot* s = slot(id)){
+        if (s->changed(vv, 0)) f->glUniform1f(s->location, v);
+    }
+}
+
+void Shader::setInt(QOpenGLFunctions_3_3_Core* f, UniformId id, int v) const
+{
+    const float zero[4] = {0, 0, 0, 0};
+    if (const UniformSlot* s = slot(id)){
+        if (s->changed(zero, v)) f->glUniform1i(s->location, v);
+    }
 }
 
-void Shader::setInt(QOpenGLFunctions_3_3_Core* f, const char* name, int v) const
+bool Shader::UniformSlot::changed(const float v[4], int i) const
 {
-    int loc = f->glGetUniformLocation(m_program, name);
-    if (loc >= 0) f->glUniform1i(loc, v);
+    if (known && std::equal(v, v + 4, value) && ivalue == i) return false;
+    known = true;
+    std::copy(v, v + 4, value);
+    ivalue = i;
+    return true;
 }
@@ -1,9 +1,31 @@
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <vector>
+
 #include <QString>
 #include <QOpenGLFunctions_3_3_Core>
 
+// Идентификатор uniform-переменной - хеш FNV-1a ее имени. При объявлении как constexpr
+// хеш вычисляется при компиляции, и установка значения не работает со строками:
+//   constexpr UniformId kModel("uModel");
+struct UniformId
+{
+    quint32 hash;
+
+    constexpr explicit UniformId(const char* name) : hash(fnv1a(name)) {}
+
+    static constexpr quint32 fnv1a(const char* s)
+    {
+        quint32 h = 2166136261u;
+        while (*s){
+            h ^= quint8(*s++);
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
+
 class Shader
 {
 public:
@@ -15,15 +37,46 @@ public:
 
     unsigned id() const { return m_program; }
 
-    // Uniform-переменные
-    void setMat4(QOpenGLFunctions_3_3_Core* f, const char* name, const float* v) const;
-    void setVec3(QOpenGLFunctions_3_3_Core* f, const char* name, float x, float y, float z) const;
-    void setFloat(QOpenGLFunctions_3_3_Core* f, const char* name, float v) const;
-    void setInt(QOpenGLFunctions_3_3_Core* f, const char* name, int v) const;
+    // Расположение активной uniform-переменной (-1, если ее нет в программе).
+    // Таблица заполняется в build() через glGetActiveUniform
+    int location(UniformId id) const;
+
+    // Связь uniform-блока программы с точкой привязки буфера (UniformBuffer/UniformRing);
+    // false, если блока в программе нет
+    bool bindUniformBlock(QOpenGLFunctions_3_3_Core* f, const char* blockName, unsigned binding) const;
+
+    // Uniform-переменные (программа должна быть текущей);
+    // значение, уже записанное в программу, повторно не передается
+    void setMat4(QOpenGLFunctions_3_3_Core* f, UniformId id, const float* v) const;
+    void setVec2(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y) const;
+    void setVec3(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y, float z) const;
+    void setFloat(QOpenGLFunctions_3_3_Core* f, UniformId id, float v) const;
+    void setInt(QOpenGLFunctions_3_3_Core* f, UniformId id, int v) const;
 
 private:
+    // Хеш-таблица с открытой адресацией: хеш имени -> расположение
+    // и последнее переданное в программу значение (матрицы не кешируются)
+    struct UniformSlot
+    {
+        quint32 hash = 0;
+        int location = -1;
+        bool used = false;
+
+        mutable bool known = false;
+        mutable float value[4] = {0, 0, 0, 0};
+        mutable int ivalue = 0;
+
+        // Запоминает значение; false, если программа уже его содержит
+        bool changed(const float v[4], int i) const;
+    };
+
+    const UniformSlot* slot(UniformId id) const;
+
     unsigned m_program = 0;
+    std::vector<UniformSlot> m_uniforms;
+
     unsigned compile(QOpenGLFunctions_3_3_Core* f, unsigned type, const char* src, QString* log);
+    void collectUniforms(QOpenGLFunctions_3_3_Core* f);
 };
 
 #endif // SHADER_H
@@ -0,0 +1,165 @@
+#include "shadervariants.h"
+
+#include <QDebug>
+
+#include "glstate.h"
+
+namespace {
+
+// Определения вставляются сразу после строки #version
+std::string withDefines(const std::string& src, const std::string& defines)
+{
+    const size_t eol = src.find('\n');
+    if (eol == std::string::npos) return src + "\n" + defines;
+    return src.substr(0, eol + 1) + defines + src.substr(eol + 1);
+}
+
+} // namespace
+
+void ShaderVariants::setSource(std::string vsSrc, std::string fsSrc, std::vector<QByteArray> features)
+{
+    m_vs = std::move(vsSrc);
+    m_fs = std::move(fsSrc);
+    m_features = std::move(features);
+    m_variants.clear();
+    m_variants.resize(size_t(1) << m_features.size());
+    m_current = -1;
+}
+
+void ShaderVariants::bindUniformBlock(const char* blockName, unsigned binding)
+{
+    m_blocks.emplace_back(QByteArray(blockName), binding);
+}
+
+bool ShaderVariants::build(QOpenGLFunctions_3_3_Core* f, unsigned mask, QString* log)
+{
+    return variant(f, mask, log) != nullptr;
+}
+
+ShaderVariants::Variant* ShaderVariants::variant(QOpenGLFunctions_3_3_Core* f, unsigned mask, QString* log)
+{
+    if (mask >= m_variants.size()) return nullptr;
+    Variant& v = m_variants[mask];
+    if (v.shader) return &v;
+    if (v.failed) return nullptr;
+
+    std::string defines;
+    for (size_t bit = 0; bit < m_features.size(); ++bit){
+        if (mask & (1u << bit)) defines += "#define " + m_features[bit].toStdString() + " 1\n";
+    }
+
+    auto shader = std::make_unique<Shader>();
+    QString buildLog;
+    if (!shader->build(f, withDefines(m_vs, defines).c_str(), withDefines(m_fs, defines).c_str(), &buildLog)){
+        qWarning().noquote() << "Shader variant" << mask << "failed to build:" << buildLog;
+        if (log) *log += buildLog;
+        v.failed = true;
+        return nullptr;
+    }
+    for (const auto& block : m_blocks) shader->bindUniformBlock(f, block.first.constData(), block.second);
+
+    v.shader = std::move(shader);
+    v.synced = 0;
+    return &v;
+}
+
+bool ShaderVariants::isCurrent(const Variant& v) const
+{
+    // Между вызовами use() могла быть установлена другая программа (GLState это знает)
+    return v.shader && GLState::instance().program() == v.shader->id();
+}
+
+void ShaderVariants::use(QOpenGLFunctions_3_3_Core* f, unsigned mask)
+{
+    if (m_current == int(mask) && isCurrent(m_variants[mask])) return;
+
+    Variant* v = variant(f, mask, nullptr);
+    if (!v){
+        m_current = -1;
+        return;
+    }
+    v->shader->use(f);
+    m_current = int(mask);
+
+    // Перенос значений, измененных после последнего использования варианта
+    if (v->synced < m_serial){
+        for (const Value& value : m_values){
+            if (value.serial > v->synced) apply(f, *v->shader, value);
+        }
+        v->synced = m_serial;
+    }
+}
+
+int ShaderVariants::variantCount() const
+{
+    int count = 0;
+    for (const auto& v : m_variants) count += v.shader ? 1 : 0;
+    return count;
+}
+
+void ShaderVariants::apply(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Value& value) const
+{
+    switch (value.type){
+    case Value::Int:   sh.setInt(f, value.id, value.i); break;
+    case Value::Float: sh.setFloat(f, value.id, value.v[0]); break;
+    case Value::Vec2:  sh.setVec2(f, value.id, value.v[0], value.v[1]); break;
+    case Value::Vec3:  sh.setVec3(f, value.id, value.v[0], value.v[1], value.v[2]); break;
+    }
+}
+
+void ShaderVariants::set(QOpenGLFunctions_3_3_Core* f, const Value& value)
+{
+    Value* slot = nullptr;
+    for (Value& v : m_values){
+        if (v.id.hash == value.id.hash){ slot = &v; break; }
+    }
+    if (!slot){
+        m_values.push_back(value);
+        slot = &m_values.back();
+    } else {
+        // Повторная установка того же значения ничего не меняет ни в одном варианте
+        if (slot->type == value.type && slot->i == value.i && slot->v[0] == value.v[0]
+            && slot->v[1] == value.v[1] && slot->v[2] == value.v[2]) return;
+        *slot = value;
+    }
+    slot->serial = ++m_serial;
+
+    // Текущий вариант получает значение сразу, остальные - при переключении
+    if (m_current >= 0 && isCurrent(m_variants[m_current])){
+        Variant& v = m_variants[m_current];
+        apply(f, *v.shader, *slot);
+        if (v.synced == m_serial - 1) v.synced = m_serial;
+    }
+}
+
+void ShaderVariants::setVec2(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y)
+{
+    Value value{id};
+    value.type = Value::Vec2;
+    value.v[0] = x; value.v[1] = y;
+    set(f, value);
+}
+
+void ShaderVariants::setVec3(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y, float z)
+{
+    Value value{id};
+    value.type = Value::Vec3;
+    value.v[0] = x; value.v[1] = y; value.v[2] = z;
+    set(f, value);
+}
+
+void ShaderVariants::setFloat(QOpenGLFunctions_3_3_Core* f, UniformId id, float v)
+{
+    Value value{id};
+    value.type = Value::Float;
+    value.v[0] = v;
+    set(f, value);
+}
+
+void ShaderVariants::setInt(QOpenGLFunctions_3_3_Core* f, UniformId id, int v)
+{
+    Value value{id};
+    value.type = Value::Int;
+    value.i = v;
+    set(f, value);
+}
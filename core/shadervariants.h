@@ -0,0 +1,78 @@
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QByteArray>
+#include <QString>
+
+#include "shader.h"
+
+// Варианты (перестановки) одной программы: бит i маски возможностей превращается
+// в "#define <features[i]> 1" после строки #version, и неиспользуемые ветви шейдера
+// отбрасываются при компиляции. Варианты собираются заранее (build) или при первом
+// обращении (use), программа переключается только при смене варианта (GLState).
+//
+// Значения uniform-переменных вне блоков запоминаются: при переключении на другой
+// вариант в него переносятся изменения, сделанные после его последнего использования.
+
+class ShaderVariants
+{
+public:
+    void setSource(std::string vsSrc, std::string fsSrc, std::vector<QByteArray> features);
+
+    // Связь uniform-блока с точкой привязки во всех вариантах
+    void bindUniformBlock(const char* blockName, unsigned binding);
+
+    // Сборка варианта заранее
+    bool build(QOpenGLFunctions_3_3_Core* f, unsigned mask, QString* log = nullptr);
+
+    // Установка варианта (glUseProgram - только при смене)
+    void use(QOpenGLFunctions_3_3_Core* f, unsigned mask);
+
+    int variantCount() const;
+
+    void setVec2(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y);
+    void setVec3(QOpenGLFunctions_3_3_Core* f, UniformId id, float x, float y, float z);
+    void setFloat(QOpenGLFunctions_3_3_Core* f, UniformId id, float v);
+    void setInt(QOpenGLFunctions_3_3_Core* f, UniformId id, int v);
+
+private:
+    struct Variant
+    {
+        std::unique_ptr<Shader> shader;
+        bool failed = false;
+        quint64 synced = 0; // Номер последнего перенесенного изменения uniform-переменных
+    };
+
+    struct Value
+    {
+        enum Type { Int, Float, Vec2, Vec3 };
+
+        UniformId id;
+        Type type = Float;
+        float v[3] = {0, 0, 0};
+        int i = 0;
+        quint64 serial = 0;
+    };
+
+    Variant* variant(QOpenGLFunctions_3_3_Core* f, unsigned mask, QString* log);
+    bool isCurrent(const Variant& v) const;
+    void apply(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Value& value) const;
+    void set(QOpenGLFunctions_3_3_Core* f, const Value& value);
+
+    std::string m_vs;
+    std::string m_fs;
+    std::vector<QByteArray> m_features;
+    std::vector<std::pair<QByteArray, unsigned>> m_blocks;
+
+    std::vector<Variant> m_variants; // Индекс - маска
+    std::vector<Value> m_values;
+    quint64 m_serial = 0;
+    int m_current = -1;
+};
+
+#endif // SHADERVARIANTS_H
@@ -1,35 +1,163 @@
 #include "texture.h"
 
-#include <QFileInfo>
-#include <QImage>
+#include <cstring>
+#include <vector>
 
-bool Texture::load(QOpenGLFunctions_3_3_Core* f, const QString& path, bool srgb)
+#include <QOpenGLContext>
+
+#include "glstate.h"
+
+// Константы расширений EXT_texture_compression_s3tc, EXT_texture_sRGB и ARB_texture_compression_rgtc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+
+bool Texture::load(QOpenGLFunctions_3_3_Core* f, const QString& path, bool srgb, TextureUsage usage)
+{
+    BakedTexture baked;
+    if (!baked.load(path, srgb, usage)) return false;
+    return upload(f, baked);
+}
+
+bool Texture::isSupported(BakedTexture::Format format, bool srgb)
 {
-    QImage img(path);
-    if (img.isNull()) return false;
-    img = img.mirrored(false, true);
-    img = img.convertToFormat(QImage::Format_RGBA8888);
-    m_w = img.width();
-    m_h = img.height();
+    switch (format){
+    case BakedTexture::Format::RGBA8:
+    case BakedTexture::Format::BC5:   // RGTC входит в ядро OpenGL 3.0
+        return true;
+    case BakedTexture::Format::BC1:
+    case BakedTexture::Format::BC3: {
+        const QOpenGLContext* ctx = QOpenGLContext::currentContext();
+        if (!ctx || !ctx->hasExtension("GL_EXT_texture_compression_s3tc")) return false;
+        return !srgb || ctx->hasExtension("GL_EXT_texture_sRGB");
+    }
+    }
+    return false;
+}
+
+bool Texture::upload(QOpenGLFunctions_3_3_Core* f, const BakedTexture& baked, const TextureSampler& sampler)
+{
+    if (baked.isNull()) return false;
+    m_w = baked.width();
+    m_h = baked.height();
 
     if (!m_id) f->glGenTextures(1, &m_id);
-    f->glBindTexture(GL_TEXTURE_2D, m_id);
+    GLState::instance().bindTexture(f, 0, m_id);
+
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampler.minFilter);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampler.magFilter);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sampler.wrapS);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sampler.wrapT);
 
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // Мип-уровни запечены заранее, glGenerateMipmap не нужен
+    const auto& levels = baked.levels();
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)levels.size() - 1);
 
-    const int internal = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
-    f->glTexImage2D(GL_TEXTURE_2D, 0, internal, m_w, m_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, img.constBits());
-    f->glGenerateMipmap(GL_TEXTURE_2D);
+    const bool srgb = baked.srgb();
+    const bool compressed = baked.isCompressed() && isSupported(baked.format(), srgb);
 
-    f->glBindTexture(GL_TEXTURE_2D, 0);
+    GLenum internal = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    if (compressed){
+        internal = GL_COMPRESSED_RG_RGTC2;
+        if (baked.format() == BakedTexture::Format::BC1){
+            internal = srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        } else if (baked.format() == BakedTexture::Format::BC3){
+            internal = srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        }
+    }
+
+    // Размещение уровней в буфере выгрузки
+    std::vector<size_t> offsets(levels.size());
+    size_t total = 0;
+    for (size_t l = 0; l < levels.size(); ++l){
+        offsets[l] = total;
+        total += compressed ? levels[l].size : size_t(levels[l].width) * size_t(levels[l].height) * 4;
+    }
+    m_gpuBytes = total;
+
+    auto fill = [&](uint8_t* dst, int l){
+        const auto& lv = levels[l];
+        if (compressed || !baked.isCompressed()){
+            std::memcpy(dst, lv.data, lv.size);
+        } else {
+            const std::vector<uint8_t> rgba = baked.decompress(l);
+            std::memcpy(dst, rgba.data(), rgba.size());
+        }
+    };
+
+    // Данные копируются в буфер пикселей (PBO), и glTexImage2D берет их оттуда:
+    // вызов не ждет копирования в текстуру, драйвер выполняет передачу асинхронно.
+    // Буфер удаляется сразу - GL освободит его после завершения передачи
+    unsigned pbo = 0;
+    f->glGenBuffers(1, &pbo);
+    f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    f->glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW);
+    auto* mapped = static_cast<uint8_t*>(f->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)total,
+                                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (mapped){
+        for (int l = 0; l < (int)levels.size(); ++l) fill(mapped + offsets[l], l);
+        if (!f->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) mapped = nullptr;
+    }
+    if (!mapped){
+        // Отображение буфера не удалось - выгрузка из памяти процесса
+        f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        f->glDeleteBuffers(1, &pbo);
+        pbo = 0;
+    }
+
+    std::vector<uint8_t> staging;
+    for (int l = 0; l < (int)levels.size(); ++l){
+        const auto& lv = levels[l];
+        const size_t bytes = (l + 1 < (int)levels.size() ? offsets[l + 1] : total) - offsets[l];
+        const void* src = reinterpret_cast<const void*>(offsets[l]);
+        if (!pbo && (compressed || !baked.isCompressed())){
+            src = lv.data;
+        } else if (!pbo){
+            staging.resize(bytes);
+            fill(staging.data(), l);
+            src = staging.data();
+        }
+        if (compressed){
+            f->glCompressedTexImage2D(GL_TEXTURE_2D, l, internal, lv.width, lv.height, 0, (GLsizei)bytes, src);
+        } else {
+            f->glTexImage2D(GL_TEXTURE_2D, l, (GLint)internal, lv.width, lv.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, src);
+        }
+    }
+
+    if (pbo){
+        f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        f->glDeleteBuffers(1, &pbo);
+    }
+
+    GLState::instance().bindTexture(f, 0, 0);
     return true;
 }
 
+void Texture::release(QOpenGLFunctions_3_3_Core* f)
+{
+    if (m_id){
+        GLState::instance().forgetTextures(&m_id, 1);
+        f->glDeleteTextures(1, &m_id);
+    }
+    m_id = 0;
+    m_w = m_h = 0;
+    m_gpuBytes = 0;
+}
+
 void Texture::bind(QOpenGLFunctions_3_3_Core* f, int unit) const
 {
-    f->glActiveTexture(GL_TEXTURE0 + unit);
-    f->glBindTexture(GL_TEXTURE_2D, m_id);
+    GLState::instance().bindTexture(f, unit, m_id);
 }
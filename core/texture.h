@@ -4,20 +4,46 @@
 #include <QString>
 #include <QOpenGLFunctions_3_3_Core>
 
+#include "bakedtexture.h"
+
+// Параметры выборки текстуры
+struct TextureSampler
+{
+    int minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    int magFilter = GL_LINEAR;
+    int wrapS = GL_REPEAT;
+    int wrapT = GL_REPEAT;
+};
+
 class Texture
 {
 public:
     Texture() = default;
     ~Texture() = default;
 
-    bool load(QOpenGLFunctions_3_3_Core* f, const QString& path, bool srgb = false);
+    bool load(QOpenGLFunctions_3_3_Core* f, const QString& path, bool srgb = false,
+              TextureUsage usage = TextureUsage::Color);
+
+    // Выгрузка запеченных мип-уровней (BakedTexture::load можно выполнить в рабочем потоке).
+    // Если GPU не поддерживает сжатый формат, уровни распаковываются в RGBA8
+    bool upload(QOpenGLFunctions_3_3_Core* f, const BakedTexture& baked,
+                const TextureSampler& sampler = TextureSampler());
     void bind(QOpenGLFunctions_3_3_Core* f, int unit) const;
 
+    // Удаление GL-объекта (нужен текущий GL-контекст)
+    void release(QOpenGLFunctions_3_3_Core* f);
+
     unsigned id() const { return m_id; }
 
+    // Объем в видеопамяти (байты, все мип-уровни)
+    size_t gpuBytes() const { return m_gpuBytes; }
+
 private:
+    static bool isSupported(BakedTexture::Format format, bool srgb);
+
     unsigned m_id = 0;
     int m_w = 0, m_h = 0;
+    size_t m_gpuBytes = 0;
 };
 
 #endif // TEXTURE_H
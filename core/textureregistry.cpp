@@ -0,0 +1,122 @@
+#include "textureregistry.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include "assetloader.h"
+#include "glstate.h"
+
+TextureRegistry& TextureRegistry::instance()
+{
+    static TextureRegistry registry;
+    return registry;
+}
+
+QString TextureRegistry::makeKey(const TextureDesc& desc)
+{
+    const TextureSampler& s = desc.sampler;
+    return QString("%1|%2|%3|%4|%5|%6|%7")
+        .arg(desc.path)
+        .arg(desc.srgb ? 1 : 0)
+        .arg(int(desc.usage))
+        .arg(s.minFilter)
+        .arg(s.magFilter)
+        .arg(s.wrapS)
+        .arg(s.wrapT);
+}
+
+TextureHandle TextureRegistry::acquire(QOpenGLFunctions_3_3_Core* f, const TextureDesc& desc)
+{
+    return acquire(f, desc, nullptr);
+}
+
+TextureHandle TextureRegistry::acquire(QOpenGLFunctions_3_3_Core* f, const TextureDesc& desc, const BakedTextureHandle& baked)
+{
+    const QString key = makeKey(desc);
+    {
+        QMutexLocker<QMutex> lock(&m_mutex);
+        auto it = m_textures.find(key);
+        if (it != m_textures.end()){
+            if (TextureHandle existing = it->second.texture.lock()) return existing;
+        }
+    }
+
+    // Текстура могла быть освобождена после проверки contains() - тогда читается здесь
+    BakedTextureHandle data = baked;
+    if (!data || data->isNull()){
+        auto loaded = std::make_shared<BakedTexture>();
+        if (!loaded->load(desc.path, desc.srgb, desc.usage)) return nullptr;
+        data = std::move(loaded);
+    }
+
+    auto* raw = new Texture();
+    if (!raw->upload(f, *data, desc.sampler)){
+        raw->release(f);
+        delete raw;
+        return nullptr;
+    }
+
+    // Последний пользователь не удаляет GL-объект сам (контекст может быть не текущим):
+    // имя ставится в очередь на удаление в collect()
+    const size_t bytes = raw->gpuBytes();
+    TextureHandle handle(raw, [this, key, bytes](const Texture* t){
+        QMutexLocker<QMutex> lock(&m_mutex);
+        if (t->id()) m_pendingFree.push_back(t->id());
+        auto it = m_textures.find(key);
+        if (it != m_textures.end() && it->second.texture.expired()) m_textures.erase(it);
+        m_residentBytes -= bytes;
+        delete t;
+    });
+
+    QMutexLocker<QMutex> lock(&m_mutex);
+    m_textures[key] = Entry{handle, bytes};
+    m_residentBytes += bytes;
+    qDebug().nospace() << "Texture " << desc.path << ": " << (bytes / 1024) << " KiB, resident "
+                       << (m_residentBytes / 1024) << " KiB in " << int(m_textures.size()) << " textures";
+    return handle;
+}
+
+void TextureRegistry::acquireAsync(const TextureDesc& desc, std::function<void(TextureHandle)> ready)
+{
+    AssetLoader::instance().run([this, desc, ready = std::move(ready)](){
+        BakedTextureHandle baked;
+        if (!contains(desc)){
+            auto loaded = std::make_shared<BakedTexture>();
+            if (loaded->load(desc.path, desc.srgb, desc.usage)) baked = std::move(loaded);
+        }
+        AssetLoader::instance().post([this, desc, ready, baked](QOpenGLFunctions_3_3_Core* f){
+            ready(acquire(f, desc, baked));
+        });
+    });
+}
+
+bool TextureRegistry::contains(const TextureDesc& desc) const
+{
+    QMutexLocker<QMutex> lock(&m_mutex);
+    auto it = m_textures.find(makeKey(desc));
+    return it != m_textures.end() && !it->second.texture.expired();
+}
+
+void TextureRegistry::collect(QOpenGLFunctions_3_3_Core* f)
+{
+    std::vector<unsigned> ids;
+    {
+        QMutexLocker<QMutex> lock(&m_mutex);
+        ids.swap(m_pendingFree);
+    }
+    if (ids.empty()) return;
+    GLState::instance().forgetTextures(ids.data(), (int)ids.size());
+    f->glDeleteTextures((int)ids.size(), ids.data());
+}
+
+size_t TextureRegistry::residentBytes() const
+{
+    QMutexLocker<QMutex> lock(&m_mutex);
+    return m_residentBytes;
+}
+
+int TextureRegistry::size() const
+{
+    QMutexLocker<QMutex> lock(&m_mutex);
+    return (int)m_textures.size();
+}
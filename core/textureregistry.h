@@ -0,0 +1,72 @@
+#ifndef TEXTUREREGISTRY_H
+#define TEXTUREREGISTRY_H
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+
+#include "texture.h"
+
+// Общий реестр текстур: одно изображение с одинаковыми параметрами загружается
+// в GPU один раз, пользователи получают разделяемые дескрипторы со счетчиком ссылок.
+// Когда последний дескриптор уничтожен, GL-объект удаляется в ближайшем collect()
+
+struct TextureDesc
+{
+    QString path;
+    bool srgb = false;
+    TextureUsage usage = TextureUsage::Color;
+    TextureSampler sampler;
+};
+
+using TextureHandle = std::shared_ptr<const Texture>;
+using BakedTextureHandle = std::shared_ptr<const BakedTexture>;
+
+class TextureRegistry
+{
+public:
+    static TextureRegistry& instance();
+
+    // Текстура из реестра либо загрузка с диска/ресурсов (GL-поток)
+    TextureHandle acquire(QOpenGLFunctions_3_3_Core* f, const TextureDesc& desc);
+
+    // То же для текстуры, уже запеченной или прочитанной из кеша в рабочем потоке
+    // (BakedTexture::load); если текстура уже загружена, данные не используются
+    TextureHandle acquire(QOpenGLFunctions_3_3_Core* f, const TextureDesc& desc, const BakedTextureHandle& baked);
+
+    // Фоновая загрузка: чтение кеша или запекание в рабочем потоке (AssetLoader),
+    // выгрузка в GPU - в AssetLoader::pump; ready вызывается в GL-потоке (nullptr при ошибке)
+    void acquireAsync(const TextureDesc& desc, std::function<void(TextureHandle)> ready);
+
+    // Загружена ли текстура (можно вызывать из любого потока, чтобы не читать ее повторно)
+    bool contains(const TextureDesc& desc) const;
+
+    // Удаление GL-объектов текстур, на которые больше никто не ссылается (GL-поток)
+    void collect(QOpenGLFunctions_3_3_Core* f);
+
+    // Объем загруженных текстур в видеопамяти (с учетом мип-уровней)
+    size_t residentBytes() const;
+    int size() const;
+
+private:
+    TextureRegistry() = default;
+
+    static QString makeKey(const TextureDesc& desc);
+
+    struct Entry
+    {
+        std::weak_ptr<const Texture> texture;
+        size_t bytes = 0;
+    };
+
+    mutable QMutex m_mutex;
+    std::unordered_map<QString, Entry> m_textures;
+    std::vector<unsigned> m_pendingFree; // GL-имена текстур без пользователей
+    size_t m_residentBytes = 0;
+};
+
+#endif // TEXTUREREGISTRY_H
@@ -0,0 +1,216 @@
+#include "trianglebvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Число корзин при разбиении по эвристике площади поверхности
+const int kSahBins = 12;
+
+Vec3 minVec(const Vec3& a, const Vec3& b) { return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)}; }
+Vec3 maxVec(const Vec3& a, const Vec3& b) { return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)}; }
+
+float axis(const Vec3& v, int a) { return a == 0 ? v.x : (a == 1 ? v.y : v.z); }
+
+float halfArea(const Vec3& mn, const Vec3& mx)
+{
+    const Vec3 d = mx - mn;
+    return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+const Vec3 kEmptyMin{ std::numeric_limits<float>::max(),  std::numeric_limits<float>::max(),  std::numeric_limits<float>::max()};
+const Vec3 kEmptyMax{-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+} // namespace
+
+void TriangleBvh::clear()
+{
+    m_nodes.clear();
+    m_triangles.clear();
+}
+
+void TriangleBvh::build(const Vertex* vertices, size_t vertexCount, const unsigned* indices, size_t indexCount)
+{
+    clear();
+
+    std::vector<BuildRef> refs;
+    refs.reserve(indexCount / 3);
+    for (size_t t = 0; t + 2 < indexCount; t += 3){
+        const unsigned i0 = indices[t], i1 = indices[t+1], i2 = indices[t+2];
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) continue;
+        const Vec3& a = vertices[i0].pos;
+        const Vec3& b = vertices[i1].pos;
+        const Vec3& c = vertices[i2].pos;
+        BuildRef r;
+        r.min = minVec(a, minVec(b, c));
+        r.max = maxVec(a, maxVec(b, c));
+        r.centroid = (r.min + r.max) * 0.5f;
+        r.index = uint32_t(t / 3);
+        refs.push_back(r);
+    }
+    if (refs.empty()) return;
+
+    m_nodes.reserve(2 * refs.size() / kMaxLeafTriangles + 1);
+    m_triangles.reserve(refs.size());
+    buildNode(refs, 0, refs.size(), vertices, indices);
+}
+
+void TriangleBvh::buildNode(std::vector<BuildRef>& refs, size_t begin, size_t end, const Vertex* vertices, const unsigned* indices)
+{
+    const size_t index = m_nodes.size();
+    m_nodes.emplace_back();
+
+    Vec3 mn = kEmptyMin, mx = kEmptyMax;
+    Vec3 cmn = kEmptyMin, cmx = kEmptyMax;
+    for (size_t k = begin; k < end; ++k){
+        mn = minVec(mn, refs[k].min);
+        mx = maxVec(mx, refs[k].max);
+        cmn = minVec(cmn, refs[k].centroid);
+        cmx = maxVec(cmx, refs[k].centroid);
+    }
+    {
+        Node& n = m_nodes[index];
+        n.min[0] = mn.x; n.min[1] = mn.y; n.min[2] = mn.z;
+        n.max[0] = mx.x; n.max[1] = mx.y; n.max[2] = mx.z;
+        n.leaf = 0;
+    }
+
+    const size_t count = end - begin;
+    if (count <= size_t(kMaxLeafTriangles)){
+        m_nodes[index].leaf = (uint32_t(m_triangles.size()) << 3) | uint32_t(count);
+        m_nodes[index].skip = uint32_t(index + 1);
+        for (size_t k = begin; k < end; ++k){
+            const size_t t = size_t(refs[k].index) * 3;
+            Triangle tri;
+            tri.v0 = vertices[indices[t]].pos;
+            tri.e1 = vertices[indices[t+1]].pos - tri.v0;
+            tri.e2 = vertices[indices[t+2]].pos - tri.v0;
+            tri.index = refs[k].index;
+            m_triangles.push_back(tri);
+        }
+        return;
+    }
+
+    // Ось с наибольшим разбросом центров; разбиение по корзинам с минимальной стоимостью SAH
+    const Vec3 ext = cmx - cmn;
+    const int a = (ext.x >= ext.y && ext.x >= ext.z) ? 0 : (ext.y >= ext.z ? 1 : 2);
+    const float lo = axis(cmn, a);
+    const float extent = axis(ext, a);
+
+    size_t mid = begin;
+    if (extent > 0.0f){
+        struct Bin { Vec3 min = kEmptyMin, max = kEmptyMax; size_t count = 0; };
+        Bin bins[kSahBins];
+        const float scale = float(kSahBins) / extent;
+        auto binOf = [&](const BuildRef& r){ return std::min(kSahBins - 1, int((axis(r.centroid, a) - lo) * scale)); };
+        for (size_t k = begin; k < end; ++k){
+            Bin& b = bins[binOf(refs[k])];
+            b.min = minVec(b.min, refs[k].min);
+            b.max = maxVec(b.max, refs[k].max);
+            ++b.count;
+        }
+
+        // Площади и числа треугольников справа от каждой границы
+        float rightArea[kSahBins];
+        size_t rightCount[kSahBins];
+        Vec3 rmn = kEmptyMin, rmx = kEmptyMax;
+        size_t rc = 0;
+        for (int b = kSahBins - 1; b > 0; --b){
+            rmn = minVec(rmn, bins[b].min);
+            rmx = maxVec(rmx, bins[b].max);
+            rc += bins[b].count;
+            rightArea[b] = rc ? halfArea(rmn, rmx) : 0.0f;
+            rightCount[b] = rc;
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+        Vec3 lmn = kEmptyMin, lmx = kEmptyMax;
+        size_t lc = 0;
+        for (int b = 1; b < kSahBins; ++b){
+            lmn = minVec(lmn, bins[b-1].min);
+            lmx = maxVec(lmx, bins[b-1].max);
+            lc += bins[b-1].count;
+            if (lc == 0 || rightCount[b] == 0) continue;
+            const float cost = halfArea(lmn, lmx) * float(lc) + rightArea[b] * float(rightCount[b]);
+            if (cost < bestCost){
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        if (bestSplit > 0){
+            mid = size_t(std::partition(refs.begin() + begin, refs.begin() + end,
+                                        [&](const BuildRef& r){ return binOf(r) < bestSplit; }) - refs.begin());
+        }
+    }
+
+    // Совпадающие центры или вырожденное разбиение - пополам по медиане
+    if (mid == begin || mid == end){
+        mid = begin + count / 2;
+        std::nth_element(refs.begin() + begin, refs.begin() + mid, refs.begin() + end,
+                         [&](const BuildRef& l, const BuildRef& r){ return axis(l.centroid, a) < axis(r.centroid, a); });
+    }
+
+    buildNode(refs, begin, mid, vertices, indices);
+    buildNode(refs, mid, end, vertices, indices);
+    m_nodes[index].skip = uint32_t(m_nodes.size());
+}
+
+bool TriangleBvh::raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const
+{
+    const Vec3 invDir = rayInverse(dir);
+    const float o[3]  = {origin.x, origin.y, origin.z};
+    const float id[3] = {invDir.x, invDir.y, invDir.z};
+
+    bool found = false;
+    const uint32_t nodeCount = uint32_t(m_nodes.size());
+    uint32_t i = 0;
+    while (i < nodeCount){
+        const Node& n = m_nodes[i];
+
+        // Метод пластин по массивам узла
+        float t0 = 0.0f, t1 = maxT;
+        for (int a = 0; a < 3; ++a){
+            float tn = (n.min[a] - o[a]) * id[a];
+            float tf = (n.max[a] - o[a]) * id[a];
+            if (tn > tf) std::swap(tn, tf);
+            t0 = std::max(t0, tn);
+            t1 = std::min(t1, tf);
+        }
+        if (t0 > t1){
+            i = n.skip;
+            continue;
+        }
+
+        if (n.leaf){
+            // Мёллер - Трумбор, обе стороны треугольника
+            const uint32_t first = n.leaf >> 3;
+            const uint32_t last = first + (n.leaf & 7u);
+            for (uint32_t k = first; k < last; ++k){
+                const Triangle& tri = m_triangles[k];
+                const Vec3 p = cross(dir, tri.e2);
+                const float det = dot(tri.e1, p);
+                if (std::abs(det) < 1e-12f) continue;
+                const float inv = 1.0f / det;
+                const Vec3 s = origin - tri.v0;
+                const float u = dot(s, p) * inv;
+                if (u < 0.0f || u > 1.0f) continue;
+                const Vec3 q = cross(s, tri.e1);
+                const float v = dot(dir, q) * inv;
+                if (v < 0.0f || u + v > 1.0f) continue;
+                const float t = dot(tri.e2, q) * inv;
+                if (t < 0.0f || t > maxT) continue;
+
+                maxT = t;
+                hit.t = t;
+                hit.triangle = int(tri.index);
+                found = true;
+            }
+        }
+        ++i;
+    }
+    return found;
+}
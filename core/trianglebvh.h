@@ -0,0 +1,68 @@
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+// Результат пересечения луча с геометрией
+struct RayHit
+{
+    float t = 0.0f;    // Параметр луча origin + t * dir
+    int part = -1;     // Часть модели (сетка объекта)
+    int triangle = -1; // Номер треугольника в индексном буфере части
+};
+
+// BVH треугольников одной сетки для точного пересечения с лучом.
+// Строится один раз при загрузке (в координатах сетки) и разделяется всеми экземплярами.
+// Узлы (32 байта) лежат в порядке обхода в глубину: левый потомок следует сразу
+// за родителем, skip - узел после всего поддерева. Обход идет без стека:
+// при попадании в узел - к следующему по порядку, при промахе - к skip.
+// Треугольники хранятся в порядке листьев (вершина и два ребра)
+
+class TriangleBvh
+{
+public:
+    static constexpr int kMaxLeafTriangles = 4;
+
+    // Треугольники indices[0..indexCount) (обычно диапазон первого уровня детализации)
+    void build(const Vertex* vertices, size_t vertexCount, const unsigned* indices, size_t indexCount);
+    void clear();
+
+    // Ближайшее пересечение при t в [0, maxT]; hit.part не меняется
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const;
+
+    bool isEmpty() const { return m_nodes.empty(); }
+    size_t memoryBytes() const { return m_nodes.size() * sizeof(Node) + m_triangles.size() * sizeof(Triangle); }
+
+private:
+    struct Node
+    {
+        float min[3];
+        uint32_t skip;
+        float max[3];
+        uint32_t leaf; // (первый треугольник << 3) | число треугольников; 0 - внутренний узел
+    };
+    static_assert(sizeof(Node) == 32, "Two BVH nodes per cache line");
+
+    struct Triangle
+    {
+        Vec3 v0, e1, e2;
+        uint32_t index;
+    };
+
+    struct BuildRef
+    {
+        Vec3 min, max, centroid;
+        uint32_t index;
+    };
+
+    void buildNode(std::vector<BuildRef>& refs, size_t begin, size_t end, const Vertex* vertices, const unsigned* indices);
+
+    std::vector<Node> m_nodes;
+    std::vector<Triangle> m_triangles;
+};
+
+#endif // TRIANGLEBVH_H
@@ -0,0 +1,67 @@
+#include "uniformbuffer.h"
+
+#include <algorithm>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+void UniformBuffer::init(QOpenGLFunctions_3_3_Core* f, size_t size, unsigned binding)
+{
+    if (!m_ubo) f->glGenBuffers(1, &m_ubo);
+    m_size = size;
+    f->glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    f->glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)size, nullptr, GL_DYNAMIC_DRAW);
+    f->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    f->glBindBufferBase(GL_UNIFORM_BUFFER, binding, m_ubo);
+}
+
+void UniformBuffer::update(QOpenGLFunctions_3_3_Core* f, const void* data, size_t size)
+{
+    f->glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    f->glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)std::min(size, m_size), data);
+    f->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::release(QOpenGLFunctions_3_3_Core* f)
+{
+    if (m_ubo) f->glDeleteBuffers(1, &m_ubo);
+    m_ubo = 0;
+    m_size = 0;
+}
+
+void UniformRing::init(QOpenGLFunctions_3_3_Core* f, size_t capacity)
+{
+    int alignment = 0;
+    f->glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) m_alignment = size_t(alignment);
+
+    if (!m_ubo) f->glGenBuffers(1, &m_ubo);
+    m_capacity = capacity;
+    m_head = 0;
+    f->glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    f->glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)capacity, nullptr, GL_STREAM_DRAW);
+    f->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRing::release(QOpenGLFunctions_3_3_Core* f)
+{
+    if (m_ubo) f->glDeleteBuffers(1, &m_ubo);
+    m_ubo = 0;
+    m_capacity = m_head = 0;
+}
+
+void UniformRing::push(QOpenGLFunctions_3_3_Core* f, unsigned binding, const void* data, size_t size)
+{
+    f->glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+
+    size_t offset = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    if (offset + size > m_capacity){
+        // Старое хранилище остается у GPU до завершения использующих его команд
+        f->glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_capacity, nullptr, GL_STREAM_DRAW);
+        offset = 0;
+    }
+    f->glBufferSubData(GL_UNIFORM_BUFFER, (GLintptr)offset, (GLsizeiptr)size, data);
+    m_head = offset + size;
+
+    f->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    f->glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_ubo, (GLintptr)offset, (GLsizeiptr)size);
+}
@@ -0,0 +1,51 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <cstddef>
+
+class QOpenGLFunctions_3_3_Core;
+
+// Буфер uniform-блока (раскладка std140 задается структурой на стороне C++).
+// Привязывается к точке привязки один раз и разделяется всеми программами,
+// в которых блок связан с той же точкой (Shader::bindUniformBlock)
+
+class UniformBuffer
+{
+public:
+    void init(QOpenGLFunctions_3_3_Core* f, size_t size, unsigned binding);
+    void update(QOpenGLFunctions_3_3_Core* f, const void* data, size_t size);
+    void release(QOpenGLFunctions_3_3_Core* f);
+
+    bool isValid() const { return m_ubo != 0; }
+
+private:
+    unsigned m_ubo = 0;
+    size_t m_size = 0;
+};
+
+// Кольцевой буфер для блоков, меняющихся на каждом вызове отрисовки:
+// данные дописываются за предыдущими, и к точке привязки подключается
+// их диапазон (glBindBufferRange). При переполнении хранилище буфера
+// заменяется новым (orphaning), поэтому запись никогда не ждет GPU
+
+class UniformRing
+{
+public:
+    void init(QOpenGLFunctions_3_3_Core* f, size_t capacity);
+    void release(QOpenGLFunctions_3_3_Core* f);
+
+    void push(QOpenGLFunctions_3_3_Core* f, unsigned binding, const void* data, size_t size);
+
+    template <typename T>
+    void push(QOpenGLFunctions_3_3_Core* f, unsigned binding, const T& block) { push(f, binding, &block, sizeof(T)); }
+
+    bool isValid() const { return m_ubo != 0; }
+
+private:
+    unsigned m_ubo = 0;
+    size_t m_capacity = 0;
+    size_t m_head = 0;
+    size_t m_alignment = 256; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+};
+
+#endif // UNIFORMBUFFER_H
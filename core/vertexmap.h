@@ -0,0 +1,95 @@
+#ifndef VERTEXMAP_H
+#define VERTEXMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ключ вершины OBJ: глобальные индексы позиции, текстурной координаты и нормали
+// со сдвигом на 1 (0 - атрибут не задан). 96 бит без упаковки, поэтому ключи
+// не совпадают ни при каком числе вершин
+struct VertexKey
+{
+    uint32_t v = 0, t = 0, n = 0;
+
+    bool operator==(const VertexKey& o) const { return v == o.v && t == o.t && n == o.n; }
+};
+
+inline VertexKey makeKey(int vi, int ti, int ni)
+{
+    return {uint32_t(vi + 1), uint32_t(ti + 1), uint32_t(ni + 1)};
+}
+
+// Таблица дедупликации вершин: открытая адресация с линейным пробированием,
+// ключи и значения лежат в одном плоском массиве, заполнение не выше 1/2
+class VertexMap
+{
+public:
+    void reserve(size_t count)
+    {
+        size_t cap = 16;
+        while (cap < count * 2) cap <<= 1;
+        if (cap > m_slots.size()) rehash(cap);
+    }
+
+    // Индекс вершины с таким ключом; если ее нет - вставляется value.
+    // inserted сообщает, была ли выполнена вставка
+    unsigned insert(const VertexKey& key, unsigned value, bool& inserted)
+    {
+        if ((m_size + 1) * 2 > m_slots.size()) rehash(std::max<size_t>(16, m_slots.size() * 2));
+
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = hash(key) & mask; ; i = (i + 1) & mask){
+            Slot& s = m_slots[i];
+            if (s.value == kEmpty){
+                s.key = key;
+                s.value = value;
+                ++m_size;
+                inserted = true;
+                return value;
+            }
+            if (s.key == key){
+                inserted = false;
+                return s.value;
+            }
+        }
+    }
+
+private:
+    static const unsigned kEmpty = ~0u;
+
+    struct Slot
+    {
+        VertexKey key;
+        unsigned value = kEmpty;
+    };
+
+    static size_t hash(const VertexKey& k)
+    {
+        uint64_t h = (uint64_t(k.v) | (uint64_t(k.t) << 32)) * 0x9E3779B97F4A7C15ull;
+        h ^= uint64_t(k.n) * 0xC2B2AE3D27D4EB4Full;
+        h ^= h >> 32;
+        h *= 0x165667B19E3779F9ull;
+        return size_t(h ^ (h >> 29));
+    }
+
+    void rehash(size_t cap)
+    {
+        std::vector<Slot> old(cap);
+        old.swap(m_slots);
+
+        const size_t mask = cap - 1;
+        for (const Slot& s : old){
+            if (s.value == kEmpty) continue;
+            size_t i = hash(s.key) & mask;
+            while (m_slots[i].value != kEmpty) i = (i + 1) & mask;
+            m_slots[i] = s;
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    size_t m_size = 0;
+};
+
+#endif // VERTEXMAP_H
@@ -7,11 +7,10 @@
 #include <QString>
 
 #include "object.h"
-#include "core/mesh.h"
+#include "core/modelcache.h"
 
+class RenderQueue;
 class Scene;
-class Shader;
-class QOpenGLFunctions_3_3_Core;
 
 class Boat : public Object
 {
@@ -19,7 +18,9 @@ public:
     explicit Boat(const QString& objPath);
 
     void update(Scene& scene, float dt) override;
-    void draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const override;
+    void submit(RenderQueue& queue, const Scene& scene) const override;
+    Bounds worldBounds() const override;
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const override;
 
     // Проверка, движется ли лодка в данный момент
     // (используется для одноразовых звуковых эффектов)
@@ -27,31 +28,11 @@ public:
 
 private:
     QString m_objPath;
-    mutable Mesh m_mesh;
-    struct ModelPart {
-        Mesh mesh;
-        Vec3 ka{0,0,0};
-        Vec3 kd{1,1,1};
-        Vec3 ks{0,0,0};
-        float ns = 16.0f;
-        float opacity = 1.0f;
-
-        // Текстуры в MTL файле
-        std::unique_ptr<Texture> mapKd; // map_Kd (диффузная текстура)
-        std::unique_ptr<Texture> mapKs; // map_Ks (спекулярная / зеркальная текстура)
-        std::unique_ptr<Texture> mapKn; // map_Kn / map_Bump / bump (карта нормалей)
-
-        bool useMapKd = false;
-        bool useMapKs = false;
-        bool useMapKn = false;
-    };
-
-    mutable bool m_uploaded = false;
-    mutable std::vector<ModelPart> m_parts;
+    mutable ModelHandle m_model;
 
     float m_targetSize = 7.0f; // Максимальный размер модели
 
-    void ensureUploaded(QOpenGLFunctions_3_3_Core* f) const;
+    void ensureUploaded() const;
 
     float m_speed = 7.5f;
 
@@ -5,8 +5,18 @@
 
 #include <QOpenGLFunctions_3_3_Core>
 
+#include "renderqueue.h"
 #include "scene.h"
-#include "core/shader.h"
+#include "uniforms.h"
+
+// Размеры макета, общие для построения геометрии и отрисовки
+static const float kDeckY = 2.0f;             // Высота центра полотна
+static const float kPierXL = -6.0f;           // Опоры разводного пролета
+static const float kPierXR = +6.0f;
+static const float kArchApproachEnd = 30.0f;  // Арки подъездов заканчиваются на |x| = 30
+static const float kRoadHalfW = 4.5f;         // Половина ширины полотна (sz m_leaf)
+static const float kDeckHalfH = 0.25f;        // Половина высоты полотна (sy m_leaf)
+static const float kCurbHalfW = 0.35f;        // Половина ширины бордюра: по ней стоят бордюры и арки
 
 static void addQuad(std::vector<Vertex>& v, std::vector<unsigned>& i,
                     const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d,
@@ -20,6 +30,23 @@ static void addQuad(std::vector<Vertex>& v, std::vector<unsigned>& i,
     i.insert(i.end(), {start, start+1, start+2, start, start+2, start+3});
 }
 
+// Полотно неподвижного подъезда от x = a до x = b: m_leaf (половина длины 12) масштабируется по X
+static Mat4 approachTransform(float a, float b)
+{
+    const float center = 0.5f * (a + b);
+    const float half = 0.5f * (b - a);
+    return Mat4::translate({center, kDeckY, 0.0f}) * Mat4::scale({half / 12.0f, 1.0f, 1.0f});
+}
+
+// Положение бордюра относительно полотна: side = -1 - левый край, +1 - правый
+static Mat4 curbOffset(float side)
+{
+    const float curbHalfH = 0.36f; // половина высоты m_curb (sy)
+
+    const float curbY = (curbHalfH - kDeckHalfH) - 0.02f; // Немного утоплен, чтобы закрыть боковую грань полотна
+    return Mat4::translate({0.0f, curbY, side * (kRoadHalfW + kCurbHalfW + 0.02f)});
+}
+
 Bridge::Bridge()
 {
     position = {0,0,0};
@@ -29,15 +56,102 @@ Bridge::Bridge()
 
 void Bridge::buildGeometry(QOpenGLFunctions_3_3_Core* f)
 {
-    makeLeaf(f);
-    makeCurbs(f);
-    makeArches(f);
-    makePiers(f);
+    const Geometry leaf = makeBox(12.0f, kDeckHalfH, kRoadHalfW, {6.0f, 2.0f});
+    const Geometry curb = makeCurb();
+
+    // Разводной пролет и его бордюры анимируются и остаются отдельными сетками
+    m_leaf.upload(f, leaf.vertices, leaf.indices);
+    m_curb.upload(f, curb.vertices, curb.indices);
+    m_leafBvh.build(leaf.vertices.data(), leaf.vertices.size(), leaf.indices.data(), leaf.indices.size());
+    m_curbBvh.build(curb.vertices.data(), curb.vertices.size(), curb.indices.data(), curb.indices.size());
     makeWater(f);
-    makeBanks(f);
+
+    // Неподвижные части запекаются в мировые координаты: по одной сетке на материал
+    // для каждой стороны моста
+    Geometry batches[StaticSideCount][StaticBatchCount];
+    auto add = [&](StaticBatch batch, const Geometry& src, const Mat4& M, const Vec2& uvMul){
+        append(batches[sideOf(M)][batch], src, M, uvMul);
+    };
+
+    // Берега: для верхней грани используем более плотный тайлинг,
+    // для боковых - меньше повторов, чтобы избежать деформаций текстуры
+    const Geometry bank = makeBankBox(22.0f, 1.5f, 28.0f, {7.0f, 7.0f}, {6.0f, 0.5f});
+    add(StaticBank, bank, Mat4::translate({-50.0f, 0.0f, 0.0f}), {4.0f, 4.0f});
+    add(StaticBank, bank, Mat4::translate({+50.0f, 0.0f, 0.0f}), {4.0f, 4.0f});
+
+    // Опоры - два параллелепипеда в реке прямо под краями разводного пролета
+    const Geometry pier = makePierBox(1.75f, 2.0f, 4.7f);
+    add(StaticPier, pier, Mat4::translate({kPierXL, 0.0f, 0.0f}), {1.0f, 1.0f});
+    add(StaticPier, pier, Mat4::translate({kPierXR, 0.0f, 0.0f}), {1.0f, 1.0f});
+
+    // Неподвижные подъезды: от края берега (совпадает с арками) до опоры и обратно.
+    // Повторы текстуры вдоль пролета растут с его длиной.
+    // Бордюры с box-mapped UV: плотность текстуры одинакова на каждой грани, а тайлинг
+    // по X увеличен пропорционально масштабу сегмента
+    const float approaches[2][2] = {{-43.0f, kPierXL}, {kPierXR, +43.0f}};
+    for (const auto& a : approaches){
+        const Mat4 M = approachTransform(a[0], a[1]);
+        const float scaleX = 0.5f * (a[1] - a[0]) / 12.0f;
+        add(StaticRoad, leaf, M, {1.0f, scaleX});
+
+        const Geometry mapped = boxMapped(curb, {0.5f * scaleX, 0.5f, 0.5f});
+        add(StaticCurb, mapped, M * curbOffset(-1.0f), {1.0f, 1.0f});
+        add(StaticCurb, mapped, M * curbOffset(+1.0f), {1.0f, 1.0f});
+    }
+
+    // Арочные фермы: больше повторов UV на ребрах, чтобы сталь не выглядела растянутой
+    const Geometry arch = makeArchUnit();
+    const Geometry rib = makeRibUnit();
+    std::vector<Mat4> arches, ribs;
+    archTransforms(arches, ribs);
+    for (const Mat4& M : arches) add(StaticSteel, arch, M, {2.0f, 2.0f});
+    for (const Mat4& M : ribs)   add(StaticSteel, rib, M, {1.0f, 10.0f});
+
+    for (int side = 0; side < StaticSideCount; ++side){
+        for (int k = 0; k < StaticBatchCount; ++k){
+            const Geometry& g = batches[side][k];
+            m_static[side][k].upload(f, g.vertices, g.indices);
+            m_staticBvh[side][k].build(g.vertices.data(), g.vertices.size(), g.indices.data(), g.indices.size());
+        }
+    }
+}
+
+void Bridge::append(Geometry& dst, const Geometry& src, const Mat4& M, const Vec2& uvMul)
+{
+    // Нормали преобразуются так же, как в шейдере (mat3(uModel) * aNrm), чтобы
+    // запеченная геометрия освещалась как раньше; нормализует фрагментный шейдер
+    const unsigned base = (unsigned)dst.vertices.size();
+    for (const Vertex& v : src.vertices){
+        Vertex t;
+        t.pos = transformPoint(M, v.pos);
+        t.nrm = normalize(transformVector(M, v.nrm));
+        t.uv = {v.uv.x * uvMul.x, v.uv.y * uvMul.y};
+        dst.vertices.push_back(t);
+    }
+    for (unsigned i : src.indices) dst.indices.push_back(base + i);
+}
+
+Bridge::StaticSide Bridge::sideOf(const Mat4& M)
+{
+    // Все детали стоят целиком по одну сторону от центра пролета (x = 0)
+    return (M.m[12] < 0.0f) ? SideLeft : SideRight;
 }
 
-Mesh Bridge::makeBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz, const Vec2& uvScale)
+Bridge::Geometry Bridge::boxMapped(Geometry g, const Vec3& s)
+{
+    // Та же проекция, что USE_BOX_MAP в шейдере: плоскость выбирается по доминирующей оси
+    // нормали (верх/низ -> XZ, +/-X -> ZY, +/-Z -> XY), координаты - в пространстве сетки
+    for (Vertex& v : g.vertices){
+        const Vec3 an{std::abs(v.nrm.x), std::abs(v.nrm.y), std::abs(v.nrm.z)};
+        const Vec3& p = v.pos;
+        if (an.y >= std::max(an.x, an.z))  v.uv = {p.x * s.x, p.z * s.z};
+        else if (an.x >= an.z)             v.uv = {p.z * s.z, p.y * s.y};
+        else                               v.uv = {p.x * s.x, p.y * s.y};
+    }
+    return g;
+}
+
+Bridge::Geometry Bridge::makeBox(float sx, float sy, float sz, const Vec2& uvScale)
 {
     std::vector<Vertex> v;
     std::vector<unsigned> i;
@@ -55,12 +169,10 @@ Mesh Bridge::makeBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz,
     addQuad(v,i, p001,p011,p111,p101, {0,0,1}, {0,0},{uvScale.x,0},{uvScale.x,uvScale.y},{0,uvScale.y});  // +Z
     addQuad(v,i, p000,p100,p110,p010, {0,0,-1}, {0,0},{uvScale.x,0},{uvScale.x,uvScale.y},{0,uvScale.y}); // -Z
 
-    Mesh m; m.upload(f, v, i);
-    return m;
+    return {std::move(v), std::move(i)};
 }
 
-Mesh Bridge::makeBankBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz,
-                         const Vec2& uvTopScale, const Vec2& uvSideScale)
+Bridge::Geometry Bridge::makeBankBox(float sx, float sy, float sz, const Vec2& uvTopScale, const Vec2& uvSideScale)
 {
     // Аналогично makeBox(), но плотное повторение текстуры только на верхней грани.
     // Боковые грани повторены реже во избежание замыленного или растянутого вида.
@@ -100,11 +212,10 @@ Mesh Bridge::makeBankBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float
     addQuad({-sx,-sy,-sz},{-sx,-sy,+sz},{-sx,+sy,+sz},{-sx,+sy,-sz},{-1,0,0},
             {0,0},{uZ,0},{uZ,vY},{0,vY});
 
-    Mesh m; m.upload(f, v, i);
-    return m;
+    return {std::move(v), std::move(i)};
 }
 
-Mesh Bridge::makePierBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz)
+Bridge::Geometry Bridge::makePierBox(float sx, float sy, float sz)
 {
     // Аналогично makeBox(), но со специальными UV: для длинных боковых
     // граней (нормаль +/-X) 2 повтора вдоль Z, чтобы избежать растяжения
@@ -132,18 +243,17 @@ Mesh Bridge::makePierBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float
     addQuad(v,i, p001,p011,p111,p101, {0,0,1}, {0,0},{u1,0},{u1,v1},{0,v1});  // +Z
     addQuad(v,i, p000,p100,p110,p010, {0,0,-1}, {0,0},{u1,0},{u1,v1},{0,v1}); // -Z
 
-    Mesh m; m.upload(f, v, i);
-    return m;
+    return {std::move(v), std::move(i)};
 }
 
 // Для вертикальных ребер для всех боковых граней V соответствует Y (высота),
 // а U соответствует горизонтальной оси (X или Z).
-Mesh Bridge::makeRibUnit(QOpenGLFunctions_3_3_Core* f)
+Bridge::Geometry Bridge::makeRibUnit()
 {
     std::vector<Vertex> v;
     std::vector<unsigned> i;
 
-    // Куб единичного размера в локальном пространстве (масштабируется при отрисовке)
+    // Куб единичного размера в локальном пространстве (масштабируется при запекании)
     float sx = 0.5f, sy = 0.5f, sz = 0.5f;
     Vec3 p000{-sx,-sy,-sz}, p001{-sx,-sy, sz}, p010{-sx, sy,-sz}, p011{-sx, sy, sz};
     Vec3 p100{ sx,-sy,-sz}, p101{ sx,-sy, sz}, p110{ sx, sy,-sz}, p111{ sx, sy, sz};
@@ -165,17 +275,10 @@ Mesh Bridge::makeRibUnit(QOpenGLFunctions_3_3_Core* f)
     // Низ -Y
     addQuad(v,i, p000,p001,p101,p100, {0,-1,0}, uv_from_xz(p000),uv_from_xz(p001),uv_from_xz(p101),uv_from_xz(p100));
 
-    Mesh m; m.upload(f, v, i);
-    return m;
+    return {std::move(v), std::move(i)};
 }
 
-void Bridge::makeLeaf(QOpenGLFunctions_3_3_Core* f)
-{
-    // Полотно моста (разводная часть / сегмент дороги)
-    m_leaf = makeBox(f, 12.0f, 0.25f, 4.5f, {6.0f, 2.0f});
-}
-
-void Bridge::makeCurbs(QOpenGLFunctions_3_3_Core* f)
+Bridge::Geometry Bridge::makeCurb()
 {
     const float hx = 12.0f;
     const float hy = 0.45f;
@@ -205,13 +308,7 @@ void Bridge::makeCurbs(QOpenGLFunctions_3_3_Core* f)
     // Внутренняя сторона -Z
     addQuad(v,i, p000,p100,p110,p010, {0,0,-1}, {0,0},{repX,0},{repX,repY},{0,repY});
 
-    m_curb.upload(f, v, i);
-}
-
-void Bridge::makePiers(QOpenGLFunctions_3_3_Core* f)
-{
-    // Опоры моста - два параллелепипеда в реке
-    m_pier = makePierBox(f, 1.75f, 2.0f, 4.7f);
+    return {std::move(v), std::move(i)};
 }
 
 void Bridge::makeWater(QOpenGLFunctions_3_3_Core* f)
@@ -230,18 +327,10 @@ void Bridge::makeWater(QOpenGLFunctions_3_3_Core* f)
     m_water.upload(f, v, i);
 }
 
-void Bridge::makeBanks(QOpenGLFunctions_3_3_Core* f)
-{
-    // Два простых берега по краям моста
-    // Для верхней грани используем более плотный тайлинг,
-    // для боковых - меньше повторов, чтобы избежать деформаций текстуры
-    m_bank = makeBankBox(f, 22.0f, 1.5f, 28.0f, {7.0f, 7.0f}, {6.0f, 0.5f});
-}
-
-void Bridge::makeArches(QOpenGLFunctions_3_3_Core* f)
+Bridge::Geometry Bridge::makeArchUnit()
 {
-    // Строится единичная арка (радиуса 1) в плоскости X–Y с выдавливанием вдоль Z
-    // Затем рисуются 4 экземпляра с разными преобразованиями (два пролета, две стороны)
+    // Строится единичная арка (радиуса 1) в плоскости X–Y с выдавливанием вдоль Z,
+    // экземпляры получаются преобразованием при запекании (archTransforms)
     std::vector<Vertex> v;
     std::vector<unsigned> ind;
 
@@ -299,295 +388,179 @@ void Bridge::makeArches(QOpenGLFunctions_3_3_Core* f)
     emitQuad(outerFront[0], outerBack[0], innerBack[0], innerFront[0]);
     emitQuad(outerBack[seg], outerFront[seg], innerFront[seg], innerBack[seg]);
 
-    m_archUnit.upload(f, v, ind);
-
-    // Базовое ребро, масштабируется для каждого экземпляра
-    m_ribUnit = makeRibUnit(f);
+    return {std::move(v), std::move(ind)};
 }
 
-void Bridge::update(Scene& scene, float dt)
+void Bridge::archTransforms(std::vector<Mat4>& arches, std::vector<Mat4>& ribs) const
 {
-    (void)dt;
-    m_lift = scene.bridgeLift;
-}
+    const float zSide = kRoadHalfW + kCurbHalfW; // Арки стоят по центру бордюра
+    const float archHalfDepth = 0.40f; // Половина толщины по оси Z
+    const float archBaseY = kDeckY + kDeckHalfH; // Старт от поверхности дороги / верха бордюра
 
-void Bridge::draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const
-{
-    // Не используется - отрисовку делают вспомогательные функции,
-    // которые корректно привязывают текстуры
-    (void)f; (void)sh;
-}
+    const int spans = std::max(1, archSpansPerApproach);
+    const int ribCount = std::max(0, archRibsPerSpan);
 
-void Bridge::drawOpaque(QOpenGLFunctions_3_3_Core* f, const Shader& sh,
-                        const Texture& roadTex,
-                        const Texture& stoneTex,
-                        const Texture& brickTex,
-                        const Texture& steelTex,
-                        const Texture& rockTex,
-                        const Texture& bankTex) const
-{
-    if (!m_leaf.isValid()){
-        const_cast<Bridge*>(this)->buildGeometry(f);
-    }
+    auto addSpan = [&](float x0, float x1, float z){
+        const float cx = 0.5f * (x0 + x1);
+        const float radius = 0.5f * (x1 - x0);
 
-    roadTex.bind(f, 0);
+        // Сама арка (единичная арка, масштабируемая до нужного радиуса)
+        arches.push_back(Mat4::translate({cx, archBaseY, z}) * Mat4::scale({radius, radius, archHalfDepth / 0.18f}));
 
-    auto setUV = [&](float mulX, float mulY){
-        int loc = f->glGetUniformLocation(sh.id(), "uUVMul");
-        if (loc >= 0) f->glUniform2f(loc, mulX, mulY);
-    };
-    setUV(1.0f, 1.0f);
+        // Вертикальные ребра внутри арки
+        for (int r = 1; r <= ribCount; ++r) {
+            float t = float(r) / float(ribCount + 1);
+            float xLocal = -1.0f + 2.0f * t;
+            float yLocal = std::sqrt(std::max(0.0f, 1.0f - xLocal * xLocal)) * 0.65f;
+            float ribH = yLocal * radius;
 
-    auto setAsphalt = [&](){
-        sh.setFloat(f, "uSpecularStrength", 0.05f);
-        sh.setFloat(f, "uSpecularPower",    12.0f);
-    };
-    auto setStone = [&](){
-        sh.setFloat(f, "uSpecularStrength", 0.15f);
-        sh.setFloat(f, "uSpecularPower",    28.0f);
-    };
-    auto setSteel = [&](){
-        sh.setFloat(f, "uSpecularStrength", 0.75f);
-        sh.setFloat(f, "uSpecularPower",    100.0f);
+            ribs.push_back(Mat4::translate({cx + xLocal * radius, archBaseY + ribH * 0.5f, z})
+                         * Mat4::scale({0.18f, ribH, 0.22f}));
+        }
     };
 
-    setAsphalt(); // Значения по умолчанию для полотна моста (асфальт)
-
-    // Рисование твердых частей моста как двусторонних, чтобы не было прозрачности,
-    // если направление обхода граней отличается
-    f->glDisable(GL_CULL_FACE);
-
-    // Макет моста:
-    // левый берег -> неподвижный пролет -> левая опора -> разводной пролет ->
-    // -> правая опора -> неподвижный пролет -> правый берег
-    // Ось моста: X (слева->вправо), Z поперек, Y вверх
-
-    const float deckY = 2.0f;
-
-    // Positions of piers along X
-    const float pierX_L = -6.0f;
-    const float pierX_R = +6.0f;
-
-    // Берега
-    {
-        setStone();
-        bankTex.bind(f, 0);
-        setUV(4.0f, 4.0f); // Умеренное повторение
-
-        // Левый берег
-        Mat4 M = Mat4::translate({-50.0f, 0.0f, 0.0f});
-        sh.setMat4(f, "uModel", M.data());
-        m_bank.draw(f);
-
-        // Правый берег
-        M = Mat4::translate({+50.0f, 0.0f, 0.0f});
-        sh.setMat4(f, "uModel", M.data());
-        m_bank.draw(f);
+    // Левый подъезд - от края до левой опоры, правый - от правой опоры до края;
+    // каждый делится на spans одинаковых арок по обеим сторонам полотна
+    const float approaches[2][2] = {{-kArchApproachEnd, kPierXL}, {kPierXR, kArchApproachEnd}};
+    for (const auto& a : approaches){
+        const float len = (a[1] - a[0]) / float(spans);
+        for (int k = 0; k < spans; ++k){
+            const float x0 = a[0] + len * float(k);
+            addSpan(x0, x0 + len, +zSide);
+            addSpan(x0, x0 + len, -zSide);
+        }
     }
+}
 
-    // Возвращение текстуры дороги и стандартного UV-повторение для полотна моста после отрисовки берегов
-    // В противном случае последующая отрисовка полотна продолжит использовать текстуру берегов
-    roadTex.bind(f, 0);
-    setUV(1.0f, 1.0f);
-    setAsphalt();
-
-    // Неподвижные пролеты
-    {
-        setAsphalt();
-        // Левый подъезд: от левого берега к левой опоре
-        // Базовый m_leaf имеет половину длины 12, X масштабируется так, чтобы покрыть ~30 единиц
-        float leftA = -43.0f;  // Край левого берега (совпадает с арками)
-        float leftB = pierX_L; // Конец на левой опоре
-        float leftCenter = 0.5f * (leftA + leftB);
-        float leftHalf = 0.5f * (leftB - leftA);
-        Mat4 M = Mat4::translate({leftCenter, deckY, 0.0f}) * Mat4::scale({leftHalf / 12.0f, 1.0f, 1.0f});
-        // leftHalf уже вычислен: объекты симметричны, поэтому имя переменной можно переиспользовать
-        setUV(1.0f, leftHalf / 12.0f);
-        sh.setMat4(f, "uModel", M.data());
-        m_leaf.draw(f);
-
-        // Правый подъезд
-        float rightA = pierX_R; // Начало на правой опоре
-        float rightB = +43.0f;  // Край правого берега
-        float rightCenter = 0.5f * (rightA + rightB);
-        float rightHalf = 0.5f * (rightB - rightA);
-        M = Mat4::translate({rightCenter, deckY, 0.0f}) * Mat4::scale({rightHalf / 12.0f, 1.0f, 1.0f});
-        setUV(1.0f, rightHalf / 12.0f);
-        sh.setMat4(f, "uModel", M.data());
-        m_leaf.draw(f);
-    }
+void Bridge::update(Scene& scene, float dt)
+{
+    (void)dt;
+    m_lift = scene.bridgeLift;
+}
 
-    // Разводной пролет между опорами
-    {
-        // Жесткий элемент - длина не должна меняться при подъеме
-        // Меш полотна центрирован в начале координат и имеет половину длины 12 (полная длина 24)
-        // Один раз масштабируется по X, чтобы получить нужную длину пролета
-        const float movableHalf = 6.0f; // Половина длины в мировых единицах (полная длина = 12)
-        float scaleX = movableHalf / 12.0f;
-
-        // Точка шарнира находится на левой опоре, на краю разводного пролета. В локальных координатах
-        // край находится в x = -12, поэтому для переноса шарнира в (0,0,0) нужно сдвинуться на (+12, 0, 0)
-        const Vec3 pivotLocal{-12.0f, 0.0f, 0.0f};
-        const Vec3 worldPivot{pierX_L, deckY, 0.0f};
-
-        const float liftAng = m_lift * (75.0f * 3.1415926f/180.0f); // Угол подъема
-
-        // Масштабирование в локальном пространстве должно быть до поворота,
-        // чтобы избежать растяжения объекта и текстуры при вращении
-        // M = T(worldPivot) * R * S * T(-pivotLocal)
-        Mat4 M = Mat4::translate(worldPivot)
-               * Mat4::rotateZ(+liftAng)
-               * Mat4::scale({scaleX, 1.0f, 1.0f})
-               * Mat4::translate({-pivotLocal.x, -pivotLocal.y, -pivotLocal.z});
-
-        setUV(1.0f, scaleX);
-        sh.setMat4(f, "uModel", M.data());
-        m_leaf.draw(f);
-    }
+float Bridge::leafScaleX()
+{
+    // Меш полотна центрирован в начале координат и имеет половину длины 12 (полная длина 24)
+    // Один раз масштабируется по X, чтобы получить нужную длину пролета
+    const float movableHalf = 0.5f * (kPierXR - kPierXL); // Половина длины в мировых единицах
+    return movableHalf / 12.0f;
+}
 
-    // Текстура скалы для опор
-    rockTex.bind(f, 0);
-    setUV(1.0f, 1.0f);
-
-    // Опоры под мостом
-    {
-        setStone();
-        // Опоры прямо под полотном моста слева и справа
-        Mat4 M = Mat4::translate({pierX_L, 0.0f, 0.0f});
-        sh.setMat4(f, "uModel", M.data());
-        m_pier.draw(f);
-
-        M = Mat4::translate({pierX_R, 0.0f, 0.0f});
-        sh.setMat4(f, "uModel", M.data());
-        m_pier.draw(f);
-    }
+Mat4 Bridge::leafTransform() const
+{
+    // Жесткий элемент - длина не должна меняться при подъеме.
+    // Точка шарнира находится на левой опоре, на краю разводного пролета. В локальных координатах
+    // край находится в x = -12, поэтому для переноса шарнира в (0,0,0) нужно сдвинуться на (+12, 0, 0)
+    const Vec3 pivotLocal{-12.0f, 0.0f, 0.0f};
+    const Vec3 worldPivot{kPierXL, kDeckY, 0.0f};
+
+    const float liftAng = m_lift * (75.0f * 3.1415926f/180.0f); // Угол подъема
+
+    // Масштабирование в локальном пространстве должно быть до поворота,
+    // чтобы избежать растяжения объекта и текстуры при вращении
+    // M = T(worldPivot) * R * S * T(-pivotLocal)
+    return Mat4::translate(worldPivot)
+         * Mat4::rotateZ(+liftAng)
+         * Mat4::scale({leafScaleX(), 1.0f, 1.0f})
+         * Mat4::translate({-pivotLocal.x, -pivotLocal.y, -pivotLocal.z});
+}
 
-    // Боковые арки (4 штуки: два пролета × две стороны)
-    {
-        const float roadHalfW = 4.5f;
-        const float curbHalfW = 0.35f; // Должно совпадать с makeCurbs
-        const float zSide = roadHalfW + curbHalfW; // Арки стоят по центру бордюра
-        const float archHalfDepth = 0.40f; // Половина толщины по оси Z
-        const float deckHalfH = 0.25f;
-        const float archBaseY = deckY + deckHalfH; // Старт от поверхности дороги / верха бордюра
-
-        auto drawArchSpan = [&](float x0, float x1, float z){
-            const float cx = 0.5f * (x0 + x1);
-            const float radius = 0.5f * (x1 - x0);
-
-            // Сама арка (единичная арка, масштабируемая до нужного радиуса)
-            Mat4 M = Mat4::translate({cx, archBaseY, z}) * Mat4::scale({radius, radius, archHalfDepth / 0.18f});
-            sh.setMat4(f, "uModel", M.data());
-            setSteel();
-            steelTex.bind(f, 0);
-            setUV(2.0f, 2.0f);
-            m_archUnit.draw(f);
-
-            // Вертикальные ребра внутри арки
-            // Больше повторов UV, чтобы сталь не выглядела растянутой на высоких ребрах
-            setUV(1.0f, 10.0f);
-            const int ribs = 9;
-            for (int r = 1; r <= ribs; ++r) {
-                float t = float(r) / float(ribs + 1);
-                float xLocal = -1.0f + 2.0f * t;
-                float yLocal = std::sqrt(std::max(0.0f, 1.0f - xLocal * xLocal)) * 0.65f;
-                float ribH = yLocal * radius;
-
-                Mat4 Rm = Mat4::translate({cx + xLocal * radius, archBaseY + ribH * 0.5f, z})
-                        * Mat4::scale({0.18f, ribH, 0.22f});
-                sh.setMat4(f, "uModel", Rm.data());
-                m_ribUnit.draw(f);
-            }
-        };
-
-        // Левый пролет: от края подъезда левого берега до левой опоры
-        drawArchSpan(-30.0f, pierX_L, +zSide);
-        drawArchSpan(-30.0f, pierX_L, -zSide);
-
-        // Правый пролет: от правой опоры до края подъезда правого берега
-        drawArchSpan(pierX_R, +30.0f, +zSide);
-        drawArchSpan(pierX_R, +30.0f, -zSide);
+Bounds Bridge::leafBounds(const Mat4& leafM) const
+{
+    Bounds b = m_leaf.bounds().transformed(leafM);
+    b.merge(m_curb.bounds().transformed(leafM * curbOffset(-1.0f)));
+    b.merge(m_curb.bounds().transformed(leafM * curbOffset(+1.0f)));
+    return b;
+}
+
+Bounds Bridge::worldBounds() const
+{
+    // Неподвижные части запечены в мировых координатах
+    Bounds b;
+    for (const auto& side : m_static){
+        for (const Mesh& m : side) b.merge(m.bounds());
     }
+    b.merge(leafBounds(leafTransform()));
+    return b;
+}
 
-    // Бордюры вдоль краев полотна (камень)
-    setStone();
-    stoneTex.bind(f, 0);
-    // Для бордюров используется box-mapped UV, чтобы плотность текстуры была одинаковой на каждой грани
-    sh.setInt(f, "uUseBoxMap", 1);
-    // Базовая плотность для box mapping
-    sh.setVec3(f, "uBoxScale", 0.5f, 0.5f, 0.5f);
-
-    auto drawCurbsFor = [&](const Mat4& baseModel, float uvMulX){
-        // Box-mapped UV вычисляются в пространстве объекта,
-        // поэтому при масштабировании сегмента вдоль X нужно пропорционально увеличить
-        // тайлинг по X, чтобы сохранить одинаковую плотность текстуры в мировом пространстве
-        const float sx = (uvMulX <= 0.0001f) ? 1.0f : uvMulX;
-        sh.setVec3(f, "uBoxScale", 0.5f * sx, 0.5f, 0.5f);
-
-        const float roadHalfW = 4.5f;  // половина ширины m_leaf (sz)
-        const float curbHalfW = 0.35f; // половина ширины m_curb (sz)
-        const float deckHalfH = 0.25f; // половина высоты m_leaf (sy)
-        const float curbHalfH = 0.36f; // половина высоты m_curb (sy)
-
-        const float curbY = (curbHalfH - deckHalfH) - 0.02f; // sink a bit to cover full side thicknessn above road; overlaps side faces
-
-        // Левый край
-        Mat4 ML = baseModel * Mat4::translate({0.0f, curbY, -(roadHalfW + curbHalfW + 0.02f)});
-        setUV(1.0f, 1.0f);
-        sh.setMat4(f, "uModel", ML.data());
-        m_curb.draw(f);
-
-        // Правый край
-        Mat4 MR = baseModel * Mat4::translate({0.0f, curbY, +(roadHalfW + curbHalfW + 0.02f)});
-        setUV(1.0f, 1.0f);
-        sh.setMat4(f, "uModel", MR.data());
-        m_curb.draw(f);
+bool Bridge::raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const
+{
+    bool found = false;
+    auto test = [&](const TriangleBvh& bvh, const Vec3& o, const Vec3& d, int part){
+        if (!bvh.raycast(o, d, maxT, hit)) return;
+        hit.part = part;
+        maxT = hit.t;
+        found = true;
     };
 
-    // Левый подъезд
-    {
-        float leftA = -43.0f;
-        float leftB = pierX_L;
-        float leftCenter = 0.5f * (leftA + leftB);
-        float leftHalf = 0.5f * (leftB - leftA);
-        Mat4 base = Mat4::translate({leftCenter, deckY, 0.0f}) * Mat4::scale({leftHalf / 12.0f, 1.0f, 1.0f});
-        drawCurbsFor(base, leftHalf / 12.0f);
+    // Неподвижные части - в мировых координатах, подвижные - в своих
+    for (int side = 0; side < StaticSideCount; ++side){
+        for (int k = 0; k < StaticBatchCount; ++k) test(m_staticBvh[side][k], origin, dir, side * StaticBatchCount + k);
     }
 
-    // Разводной пролет
-    {
-        float movableA = pierX_L;
-        float movableB = pierX_R;
-        float movableHalf = 0.5f * (movableB - movableA);
-        const float liftAng = m_lift * (75.0f * 3.1415926f/180.0f);
-
-        Vec3 worldPivot{pierX_L, deckY, 0.0f};
-        Vec3 pivotLocal{-12.0f, 0.0f, 0.0f};
-
-        Mat4 M = Mat4::translate(worldPivot) * Mat4::rotateZ(+liftAng) * Mat4::scale({movableHalf/12.0f, 1.0f, 1.0f}) * Mat4::translate({+12.0f, 0.0f, 0.0f}); // T(pivot)*R*S*T(-pivotLocal)
-        // Для бордюров переиспользуется матрица, как у разводного полотна
-        drawCurbsFor(M, movableHalf/12.0f);
+    const Mat4 M = leafTransform();
+    const Mat4 parts[3] = {M, M * curbOffset(-1.0f), M * curbOffset(+1.0f)};
+    for (int k = 0; k < 3; ++k){
+        Vec3 o, d;
+        rayToLocal(parts[k], origin, dir, o, d);
+        test(k == 0 ? m_leafBvh : m_curbBvh, o, d, kLeafPart + k);
     }
+    return found;
+}
 
-    // Правый подъезд
-    {
-        float rightA = pierX_R;
-        float rightB = +43.0f;
-        float rightCenter = 0.5f * (rightA + rightB);
-        float rightHalf = 0.5f * (rightB - rightA);
-        Mat4 base = Mat4::translate({rightCenter, deckY, 0.0f}) * Mat4::scale({rightHalf / 12.0f, 1.0f, 1.0f});
-        drawCurbsFor(base, rightHalf / 12.0f);
+void Bridge::submit(RenderQueue& queue, const Scene& scene) const
+{
+    if (!m_leaf.isValid()) return; // Геометрия строится в Scene::init
+
+    // Твердые части моста рисуются двусторонними, чтобы не было прозрачности,
+    // если направление обхода граней отличается. Тайлинг запечен в UV (uUVMul = 1)
+    auto material = [](const TextureHandle& tex, float specStrength, float specPower){
+        RenderMaterial m;
+        m.texture = tex.get();
+        m.specularStrength = specStrength;
+        m.specularPower = specPower;
+        m.doubleSided = true;
+        return m;
+    };
+    const RenderMaterial asphalt = material(scene.texRoad, 0.05f, 12.0f);
+    auto stone = [&](const TextureHandle& tex){ return material(tex, 0.15f, 28.0f); };
+
+    // Неподвижные части - по одному вызову на материал и сторону; мост целиком прошел
+    // отсечение сцены, но каждая его сетка проверяется по своим границам отдельно
+    const RenderMaterial materials[StaticBatchCount] = {
+        stone(scene.texBank),
+        stone(scene.texRock),
+        asphalt,
+        stone(scene.texStone),
+        material(scene.texSteel, 0.75f, 100.0f)
+    };
+    const Mat4 I = Mat4::identity();
+    for (const auto& side : m_static){
+        for (int k = 0; k < StaticBatchCount; ++k){
+            if (!side[k].isValid() || !scene.frustum.intersects(side[k].bounds())) continue;
+            queue.submit(side[k], 0, LitTexture, materials[k], I);
+        }
     }
 
-    roadTex.bind(f, 0);
-    sh.setInt(f, "uUseBoxMap", 0);
-
-    // Опоры - кирпич
-    brickTex.bind(f, 0);
-    f->glEnable(GL_CULL_FACE);
+    // Разводной пролет между опорами
+    const float scaleX = leafScaleX();
+    const Mat4 M = leafTransform();
+    if (!scene.frustum.intersects(leafBounds(M))) return;
+
+    RenderMaterial leaf = asphalt;
+    leaf.uvMul = {1.0f, scaleX};
+    queue.submit(m_leaf, 0, LitTexture, leaf, M);
+
+    // Бордюры разводного пролета повторяют его матрицу. Box-mapped UV вычисляются
+    // в пространстве объекта, поэтому тайлинг по X увеличен пропорционально масштабу
+    RenderMaterial curb = stone(scene.texStone);
+    curb.boxScale = {0.5f * scaleX, 0.5f, 0.5f};
+    queue.submit(m_curb, 0, LitTexture | LitBoxMap, curb, M * curbOffset(-1.0f));
+    queue.submit(m_curb, 0, LitTexture | LitBoxMap, curb, M * curbOffset(+1.0f));
 }
 
-void Bridge::drawWater(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Texture& waterTex, const Vec2& uvOffset) const
+void Bridge::drawWater(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Scene& scene, const Texture& waterTex, const Vec2& uvOffset) const
 {
     if (!m_water.isValid()){
         const_cast<Bridge*>(this)->buildGeometry(f);
@@ -595,15 +568,8 @@ void Bridge::drawWater(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Tex
     waterTex.bind(f, 0);
 
     Mat4 M = Mat4::translate({0.0f, 0.0f, 0.0f});
-    sh.setMat4(f, "uModel", M.data());
-    sh.setFloat(f, "uUVOffset.x", 0.0f); // Не используется
-    int loc = f->glGetUniformLocation(sh.id(), "uUVOffset");
-    if (loc >= 0) f->glUniform2f(loc, uvOffset.x, uvOffset.y);
+    scene.setModel(f, M);
+    sh.setVec2(f, Uniform::UVOffset, uvOffset.x, uvOffset.y);
 
     m_water.draw(f);
-
-    // Сброс материала к значениям по умолчанию
-    // (чтобы остальные объекты сохранили исходный вид)
-    sh.setFloat(f, "uSpecularStrength", 0.25f);
-    sh.setFloat(f, "uSpecularPower",    32.0f);
 }
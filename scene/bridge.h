@@ -1,10 +1,14 @@
 #ifndef BRIDGE_H
 #define BRIDGE_H
 
+#include <vector>
+
 #include "object.h"
 #include "core/mesh.h"
 #include "core/texture.h"
+#include "core/trianglebvh.h"
 
+class RenderQueue;
 class Scene;
 class Shader;
 class QOpenGLFunctions_3_3_Core;
@@ -20,42 +24,86 @@ public:
     Bridge();
 
     void update(Scene& scene, float dt) override;
-    void draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const override;
-
-    // Вспомогательные методы для отрисовки с текстурами/шейдерами
-    void drawOpaque(QOpenGLFunctions_3_3_Core* f, const Shader& sh,
-                    const Texture& roadTex,
-                    const Texture& stoneTex,
-                    const Texture& brickTex,
-                    const Texture& steelTex,
-                    const Texture& rockTex,
-                    const Texture& bankTex) const;
-    void drawWater(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Texture& waterTex, const Vec2& uvOffset) const;
+    void submit(RenderQueue& queue, const Scene& scene) const override;
+    Bounds worldBounds() const override;
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const override;
+
+    // Вода рисуется отдельным проходом со своей программой
+    void drawWater(QOpenGLFunctions_3_3_Core* f, const Shader& sh, const Scene& scene, const Texture& waterTex, const Vec2& uvOffset) const;
 
     void buildGeometry(QOpenGLFunctions_3_3_Core* f);
 
+    // Арочные фермы подъездов (задаются до buildGeometry): число арок на каждом подъезде
+    // с каждой стороны полотна и число вертикальных ребер под каждой аркой
+    int archSpansPerApproach = 1;
+    int archRibsPerSpan = 9;
+
 private:
-    Mesh makeBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz, const Vec2& uvScale);
+    // Геометрия на CPU до выгрузки (для запекания в общие сетки)
+    struct Geometry
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned> indices;
+    };
+
+    // Неподвижные части, объединенные по материалу
+    enum StaticBatch
+    {
+        StaticBank,  // Берега (кирпич)
+        StaticPier,  // Опоры (скала)
+        StaticRoad,  // Полотно подъездов (асфальт)
+        StaticCurb,  // Бордюры подъездов (камень, box-mapped UV)
+        StaticSteel, // Арки и ребра
+        StaticBatchCount
+    };
+
+    // Неподвижные части каждого материала делятся на левый и правый подъезды
+    // (берег, опора, полотно, бордюры и арки одной стороны): у каждой сетки
+    // свои границы, и она отсекается отдельно
+    enum StaticSide
+    {
+        SideLeft,
+        SideRight,
+        StaticSideCount
+    };
 
-    Mesh makePierBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz);
-    Mesh makeBankBox(QOpenGLFunctions_3_3_Core* f, float sx, float sy, float sz, const Vec2& uvTopScale, const Vec2& uvSideScale);
-    Mesh makeRibUnit(QOpenGLFunctions_3_3_Core* f);
+    static Geometry makeBox(float sx, float sy, float sz, const Vec2& uvScale);
+    static Geometry makePierBox(float sx, float sy, float sz);
+    static Geometry makeBankBox(float sx, float sy, float sz, const Vec2& uvTopScale, const Vec2& uvSideScale);
+    static Geometry makeRibUnit();
+    static Geometry makeArchUnit();
+    static Geometry makeCurb();
+
+    // Преобразования арок и ребер под ними (по archSpansPerApproach/archRibsPerSpan)
+    void archTransforms(std::vector<Mat4>& arches, std::vector<Mat4>& ribs) const;
+
+    // Добавление src, преобразованной матрицей M, с тайлингом uvMul, запеченным в UV
+    static void append(Geometry& dst, const Geometry& src, const Mat4& M, const Vec2& uvMul);
+    // UV по проекции на грани параллелепипеда (как USE_BOX_MAP)
+    static Geometry boxMapped(Geometry g, const Vec3& scale);
+    // Сторона моста, к которой относится деталь с преобразованием M
+    static StaticSide sideOf(const Mat4& M);
 
-    void makeLeaf(QOpenGLFunctions_3_3_Core* f);
-    void makeCurbs(QOpenGLFunctions_3_3_Core* f);
-    void makeArches(QOpenGLFunctions_3_3_Core* f);
-    void makePiers(QOpenGLFunctions_3_3_Core* f);
     void makeWater(QOpenGLFunctions_3_3_Core* f);
-    void makeBanks(QOpenGLFunctions_3_3_Core* f);
+
+    // Масштаб разводного пролета по X и его матрица при текущем подъеме
+    static float leafScaleX();
+    Mat4 leafTransform() const;
+    // Границы разводного пролета с бордюрами (мировые координаты)
+    Bounds leafBounds(const Mat4& leafM) const;
 
 private:
-    Mesh m_leaf;
-    Mesh m_curb;
-    Mesh m_archUnit; // Базовая арка единичного радиуса для матрицы преобразований
-    Mesh m_ribUnit;  // Базовый вертикальный параллелепипед для опор под аркой
-    Mesh m_pier;
+    Mesh m_leaf;  // Разводной пролет
+    Mesh m_curb;  // Бордюр разводного пролета
     Mesh m_water;
-    Mesh m_bank;
+    Mesh m_static[StaticSideCount][StaticBatchCount];
+
+    // BVH для выбора лучом. Номера частей в RayHit: side * StaticBatchCount + batch,
+    // затем пролет (kLeafPart) и его бордюры (kLeafPart + 1, + 2)
+    static constexpr int kLeafPart = StaticSideCount * StaticBatchCount;
+    TriangleBvh m_staticBvh[StaticSideCount][StaticBatchCount];
+    TriangleBvh m_leafBvh;
+    TriangleBvh m_curbBvh;
 
     // Кешированное состояние из Scene
     float m_lift = 0.0f;
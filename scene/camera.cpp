@@ -22,7 +22,13 @@ Mat4 Camera::view() const
 
 Mat4 Camera::proj(float aspect) const
 {
-    return Mat4::perspective(45.0f * 3.1415926f/180.0f, aspect, 0.1f, 500.0f);
+    return Mat4::perspective(kFovY, aspect, 0.1f, 500.0f);
+}
+
+float Camera::pixelsPerUnit(float distance, int viewportHeight) const
+{
+    const float d = std::max(distance, 0.1f);
+    return float(viewportHeight) / (2.0f * std::tan(kFovY * 0.5f) * d);
 }
 
 void Camera::rotate(float dyaw, float dpitch)
@@ -16,9 +16,14 @@ public:
     // Боковое смещение влево/вправо вдоль оси X
     float strafe = 0.0f;
 
+    static constexpr float kFovY = 45.0f * 3.1415926f/180.0f; // Радианы
+
     Mat4 view() const;
     Mat4 proj(float aspect) const;
 
+    // Сколько пикселей занимает единица длины на расстоянии distance
+    float pixelsPerUnit(float distance, int viewportHeight) const;
+
     Vec3 eye() const;
 
     void rotate(float dyaw, float dpitch);
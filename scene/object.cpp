@@ -8,3 +8,10 @@ Mat4 Object::modelMatrix() const
     Mat4 S = Mat4::scale(scale);
     return T * R * S;
 }
+
+void Object::rayToLocal(const Mat4& model, const Vec3& origin, const Vec3& dir, Vec3& localOrigin, Vec3& localDir) const
+{
+    const Mat4 inv = inverse(model);
+    localOrigin = transformPoint(inv, origin);
+    localDir = transformVector(inv, dir);
+}
@@ -1,13 +1,12 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
+#include "core/bounds.h"
 #include "core/math3d.h"
 
-class Mesh;
+class RenderQueue;
 class Scene;
-class Shader;
-class Texture;
-class QOpenGLFunctions_3_3_Core;
+struct RayHit;
 
 class Object
 {
@@ -19,9 +18,22 @@ public:
     Vec3 scale{1,1,1};
 
     virtual void update(Scene& scene, float dt) { (void)scene; (void)dt; }
-    virtual void draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const = 0;
+    // Добавление пакетов отрисовки в очередь кадра
+    virtual void submit(RenderQueue& queue, const Scene& scene) const = 0;
+
+    // Границы в мировых координатах для отсечения; пустые - объект не отсекается
+    virtual Bounds worldBounds() const { return Bounds(); }
+
+    // Точное пересечение луча (мировые координаты) с треугольниками объекта;
+    // hit.t - в длинах dir, как у луча в мировых координатах
+    virtual bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const
+    { (void)origin; (void)dir; (void)maxT; (void)hit; return false; }
 
     Mat4 modelMatrix() const;
+
+protected:
+    // Луч в координатах модели: параметр t при аффинном преобразовании не меняется
+    void rayToLocal(const Mat4& model, const Vec3& origin, const Vec3& dir, Vec3& localOrigin, Vec3& localDir) const;
 };
 
 #endif // OBJECT_H
@@ -0,0 +1,234 @@
+#include "renderqueue.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include "scene.h"
+#include "uniforms.h"
+#include "core/mesh.h"
+#include "core/shadervariants.h"
+#include "core/texture.h"
+
+namespace {
+
+inline void hashCombine(size_t& seed, size_t v)
+{
+    seed ^= v + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+inline size_t hashFloat(float v) { return std::hash<float>()(v); }
+
+bool sameVec3(const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+} // namespace
+
+bool RenderMaterial::operator==(const RenderMaterial& o) const
+{
+    return texture == o.texture && specularMap == o.specularMap
+        && sameVec3(tint, o.tint) && uvMul.x == o.uvMul.x && uvMul.y == o.uvMul.y
+        && sameVec3(boxScale, o.boxScale)
+        && specularStrength == o.specularStrength && specularPower == o.specularPower
+        && doubleSided == o.doubleSided;
+}
+
+size_t RenderQueue::MaterialHash::operator()(const RenderMaterial& m) const
+{
+    size_t h = std::hash<const void*>()(m.texture);
+    hashCombine(h, std::hash<const void*>()(m.specularMap));
+    for (float v : {m.tint.x, m.tint.y, m.tint.z, m.uvMul.x, m.uvMul.y,
+                    m.boxScale.x, m.boxScale.y, m.boxScale.z, m.specularStrength, m.specularPower}){
+        hashCombine(h, hashFloat(v));
+    }
+    hashCombine(h, m.doubleSided ? 1u : 0u);
+    return h;
+}
+
+size_t RenderQueue::GroupKeyHash::operator()(const GroupKey& k) const
+{
+    size_t h = std::hash<const void*>()(k.mesh);
+    hashCombine(h, size_t(k.lod));
+    hashCombine(h, size_t(k.variant));
+    hashCombine(h, size_t(k.material));
+    return h;
+}
+
+void RenderQueue::begin(const Vec3& eye)
+{
+    m_eye = eye;
+    m_packets.clear();
+    m_transforms.clear();
+    m_materials.clear();
+    m_materialTextureSet.clear();
+    m_materialIds.clear();
+    m_textureSets.clear();
+    for (int g = 0; g < m_groupCount; ++g) m_groups[g].instances.clear();
+    m_groupCount = 0;
+    m_groupIds.clear();
+    m_instances.clear();
+}
+
+int RenderQueue::textureSetIndex(const RenderMaterial& material)
+{
+    // Наборов текстур в кадре немного, линейного поиска достаточно
+    const std::pair<const Texture*, const Texture*> set(material.texture, material.specularMap);
+    for (size_t k = 0; k < m_textureSets.size(); ++k){
+        if (m_textureSets[k] == set) return (int)k;
+    }
+    m_textureSets.push_back(set);
+    return (int)m_textureSets.size() - 1;
+}
+
+int RenderQueue::materialIndex(const RenderMaterial& material)
+{
+    auto it = m_materialIds.find(material);
+    if (it != m_materialIds.end()) return it->second;
+
+    const int index = (int)m_materials.size();
+    m_materials.push_back(material);
+    m_materialTextureSet.push_back(textureSetIndex(material));
+    m_materialIds.emplace(material, index);
+    return index;
+}
+
+quint64 RenderQueue::makeKey(unsigned variant, int material, float distance) const
+{
+    // Номера сверх разрядности ключа только ухудшают группировку: выполнение
+    // использует сам материал пакета, а не биты ключа
+    const quint64 textureSet = quint64(m_materialTextureSet[material]) & (kMaxTextureSets - 1);
+    const quint64 mat = quint64(material) & (kMaxMaterials - 1);
+    const float t = std::max(0.0f, std::min(1.0f, distance / kDepthRange));
+    const quint64 depth = quint64(t * float(0xFFFFFF));
+
+    return (quint64(variant & 0xFu) << 60) | (textureSet << 48) | (mat << 36) | (depth << 12);
+}
+
+void RenderQueue::submit(const Mesh& mesh, int lod, unsigned variant, const RenderMaterial& material, const Mat4& model)
+{
+    Packet p;
+    p.mesh = &mesh;
+    p.lod = lod;
+    p.variant = variant;
+    p.material = materialIndex(material);
+    p.kind = Kind::Single;
+    p.transform = (int)m_transforms.size();
+    m_transforms.push_back(model);
+
+    const Vec3 origin{model.m[12], model.m[13], model.m[14]};
+    p.key = makeKey(variant, p.material, length(origin - m_eye));
+    m_packets.push_back(p);
+}
+
+void RenderQueue::submitInstance(const Mesh& mesh, int lod, unsigned variant, const RenderMaterial& material,
+                                 const InstanceData& instance, const Vec3& center)
+{
+    const GroupKey key{&mesh, lod, variant, materialIndex(material)};
+    const float distance = length(center - m_eye);
+
+    auto it = m_groupIds.find(key);
+    if (it == m_groupIds.end()){
+        if (m_groupCount == (int)m_groups.size()) m_groups.emplace_back();
+        Group& g = m_groups[m_groupCount];
+        g.key = key;
+        g.nearest = distance;
+        it = m_groupIds.emplace(key, m_groupCount++).first;
+    }
+    Group& g = m_groups[it->second];
+    g.instances.push_back(instance);
+    g.nearest = std::min(g.nearest, distance);
+}
+
+void RenderQueue::radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+{
+    // LSD по байтам ключа; проходы, в которых байт одинаков у всех пакетов, пропускаются
+    scratch.resize(items.size());
+    for (int pass = 0; pass < 8; ++pass){
+        const int shift = pass * 8;
+        size_t count[256] = {};
+        for (const SortItem& it : items) ++count[(it.key >> shift) & 0xFFu];
+        if (count[(items.front().key >> shift) & 0xFFu] == items.size()) continue;
+
+        size_t offset = 0;
+        for (size_t& c : count){
+            const size_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const SortItem& it : items) scratch[count[(it.key >> shift) & 0xFFu]++] = it;
+        items.swap(scratch);
+    }
+}
+
+void RenderQueue::apply(QOpenGLFunctions_3_3_Core* f, ShaderVariants& sh, const RenderMaterial& m)
+{
+    if (m.texture) m.texture->bind(f, 0);
+    if (m.specularMap) m.specularMap->bind(f, 1);
+    sh.setVec3(f, Uniform::Tint, m.tint.x, m.tint.y, m.tint.z);
+    sh.setVec2(f, Uniform::UVMul, m.uvMul.x, m.uvMul.y);
+    sh.setVec3(f, Uniform::BoxScale, m.boxScale.x, m.boxScale.y, m.boxScale.z);
+    sh.setFloat(f, Uniform::SpecularStrength, m.specularStrength);
+    sh.setFloat(f, Uniform::SpecularPower, m.specularPower);
+}
+
+void RenderQueue::flush(QOpenGLFunctions_3_3_Core* f, ShaderVariants& sh, const Scene& scene)
+{
+    // Группы экземпляров становятся пакетами; их параметры выгружаются одним блоком
+    for (int g = 0; g < m_groupCount; ++g){
+        const Group& group = m_groups[g];
+        Packet p;
+        p.mesh = group.key.mesh;
+        p.lod = group.key.lod;
+        p.variant = group.key.variant;
+        p.material = group.key.material;
+        p.kind = Kind::Streamed;
+        p.instances.offset = m_instances.size();
+        p.instances.count = (int)group.instances.size();
+        p.key = makeKey(p.variant, p.material, group.nearest);
+        m_instances.insert(m_instances.end(), group.instances.begin(), group.instances.end());
+        m_packets.push_back(p);
+    }
+    if (m_packets.empty()) return;
+
+    InstanceBatch streamed;
+    if (!m_instances.empty()) streamed = scene.instances.push(f, m_instances.data(), (int)m_instances.size());
+
+    m_sorted.resize(m_packets.size());
+    for (size_t k = 0; k < m_packets.size(); ++k) m_sorted[k] = {m_packets[k].key, quint32(k)};
+    radixSort(m_sorted, m_scratch);
+
+    unsigned variant = ~0u;
+    int material = -1;
+    int cullFace = -1;
+    for (const SortItem& item : m_sorted){
+        const Packet& p = m_packets[item.index];
+
+        if (p.variant != variant){
+            sh.use(f, p.variant);
+            variant = p.variant;
+        }
+        if (p.material != material){
+            const RenderMaterial& m = m_materials[p.material];
+            apply(f, sh, m);
+            const int cull = m.doubleSided ? 0 : 1;
+            if (cull != cullFace){
+                if (cull) f->glEnable(GL_CULL_FACE); else f->glDisable(GL_CULL_FACE);
+                cullFace = cull;
+            }
+            material = p.material;
+        }
+
+        switch (p.kind){
+        case Kind::Single:
+            scene.setModel(f, m_transforms[p.transform]);
+            p.mesh->draw(f, p.lod);
+            break;
+        case Kind::Streamed:
+            // Без выгруженного блока (поток не создан) группа пропускается
+            if (streamed.count > 0) p.mesh->drawInstanced(f, streamed.sub(int(p.instances.offset), p.instances.count), p.lod);
+            break;
+        }
+    }
+
+    if (cullFace == 0) f->glEnable(GL_CULL_FACE);
+}
@@ -0,0 +1,139 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "core/instancestream.h"
+#include "core/math3d.h"
+
+class Mesh;
+class Scene;
+class ShaderVariants;
+class Texture;
+class QOpenGLFunctions_3_3_Core;
+
+// Материал программы освещения (uniform-переменные вне блоков и текстуры)
+struct RenderMaterial
+{
+    const Texture* texture = nullptr;     // uTex, блок 0 (LitTexture)
+    const Texture* specularMap = nullptr; // uMapKs, блок 1 (LitSpecularMap)
+    Vec3 tint{1.0f, 1.0f, 1.0f};
+    Vec2 uvMul{1.0f, 1.0f};
+    Vec3 boxScale{1.0f, 1.0f, 1.0f};      // LitBoxMap
+    float specularStrength = 0.25f;
+    float specularPower = 32.0f;
+    bool doubleSided = false;             // Без отсечения задних граней
+
+    bool operator==(const RenderMaterial& o) const;
+};
+
+// Очередь отрисовки непрозрачной геометрии программы освещения.
+// Объекты сцены добавляют пакеты (вариант программы, материал, сетка, преобразование)
+// вместо прямых вызовов GL; flush сортирует их по 64-битному ключу поразрядной
+// сортировкой и выполняет, переключая программу и материал только на границах групп.
+//
+// Ключ (старшие биты - самые дорогие переключения):
+//   63..60 - вариант программы (маска LitFeature);
+//   59..48 - набор текстур (порядковый номер в кадре);
+//   47..36 - материал (порядковый номер в кадре);
+//   35..12 - расстояние до камеры (ближние раньше);
+//   11..0  - не используются.
+//
+// Экземпляры (submitInstance) с одинаковыми сеткой, уровнем, вариантом и материалом
+// собираются в один вызов с параметрами из InstanceStream сцены.
+
+class RenderQueue
+{
+public:
+    static constexpr int kMaxTextureSets = 1 << 12;
+    static constexpr int kMaxMaterials = 1 << 12;
+    static constexpr float kDepthRange = 1024.0f; // Дальше все пакеты считаются одинаково далекими
+
+    // Начало кадра: очистка пакетов, точка отсчета глубины
+    void begin(const Vec3& eye);
+
+    // Отдельный вызов с матрицей модели из блока ObjectUniforms
+    void submit(const Mesh& mesh, int lod, unsigned variant, const RenderMaterial& material, const Mat4& model);
+
+    // Экземпляр для автоматического инстансинга; center - опорная точка для глубины
+    void submitInstance(const Mesh& mesh, int lod, unsigned variant, const RenderMaterial& material,
+                        const InstanceData& instance, const Vec3& center);
+
+    // Сортировка и выполнение накопленных пакетов
+    void flush(QOpenGLFunctions_3_3_Core* f, ShaderVariants& sh, const Scene& scene);
+
+    int packetCount() const { return (int)m_packets.size(); }
+
+private:
+    enum class Kind { Single, Streamed };
+
+    struct Packet
+    {
+        quint64 key = 0;
+        const Mesh* mesh = nullptr;
+        int lod = 0;
+        unsigned variant = 0;
+        int material = 0;
+        Kind kind = Kind::Single;
+        int transform = 0;       // Single: индекс в m_transforms
+        InstanceBatch instances; // Streamed: offset - номер первого экземпляра в m_instances
+    };
+
+    struct SortItem
+    {
+        quint64 key;
+        quint32 index;
+    };
+
+    // Группа автоматического инстансинга
+    struct GroupKey
+    {
+        const Mesh* mesh;
+        int lod;
+        unsigned variant;
+        int material;
+
+        bool operator==(const GroupKey& o) const
+        {
+            return mesh == o.mesh && lod == o.lod && variant == o.variant && material == o.material;
+        }
+    };
+    struct GroupKeyHash { size_t operator()(const GroupKey& k) const; };
+    struct MaterialHash { size_t operator()(const RenderMaterial& m) const; };
+
+    struct Group
+    {
+        GroupKey key;
+        std::vector<InstanceData> instances;
+        float nearest = 0.0f;
+    };
+
+    int materialIndex(const RenderMaterial& material);
+    int textureSetIndex(const RenderMaterial& material);
+    quint64 makeKey(unsigned variant, int material, float distance) const;
+    void apply(QOpenGLFunctions_3_3_Core* f, ShaderVariants& sh, const RenderMaterial& material);
+
+    static void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+
+    Vec3 m_eye;
+    std::vector<Packet> m_packets;
+    std::vector<Mat4> m_transforms;
+
+    std::vector<RenderMaterial> m_materials;
+    std::vector<int> m_materialTextureSet;
+    std::unordered_map<RenderMaterial, int, MaterialHash> m_materialIds;
+    std::vector<std::pair<const Texture*, const Texture*>> m_textureSets;
+
+    std::vector<Group> m_groups;
+    int m_groupCount = 0; // Группы кадра; векторы прошлых кадров переиспользуются
+    std::unordered_map<GroupKey, int, GroupKeyHash> m_groupIds;
+    std::vector<InstanceData> m_instances;
+
+    std::vector<SortItem> m_sorted;
+    std::vector<SortItem> m_scratch;
+};
+
+#endif // RENDERQUEUE_H
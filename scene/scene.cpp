@@ -1,7 +1,9 @@
 #include "scene.h"
 
 #include <algorithm>
+#include <limits>
 #include <random>
+#include <string>
 
 #include <QOpenGLFunctions_3_3_Core>
 #include <QDir>
@@ -15,16 +17,47 @@
 #include "bridge.h"
 #include "vehicle.h"
 #include "boat.h"
+#include "uniforms.h"
+#include "core/assetloader.h"
+#include "core/glstate.h"
+#include "core/modelcache.h"
+
+// Uniform-блоки, общие для всех программ сцены (раскладка - FrameUniforms/ObjectUniforms
+// в uniforms.h); объявления во всех шейдерах должны совпадать, поэтому они подставляются
+// в исходники при сборке программ (см. Scene::init)
+static const char* GLSL_VERSION = "#version 330 core\n";
+
+static const char* GLSL_FRAME_UNIFORMS = R"GLSL(
+layout(std140) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProj;
+    vec3 uCamPos;
+    float uAmbient;
+    vec3 uSunDir;
+    float uNight;
+    vec3 uSunColor;
+};
+)GLSL";
+
+static const char* GLSL_OBJECT_UNIFORMS = R"GLSL(
+layout(std140) uniform ObjectUniforms {
+    mat4 uModel;
+};
+)GLSL";
 
 static const char* VS_LIT = R"GLSL(
-#version 330 core
 layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aNrm;
 layout(location=2) in vec2 aUV;
+// Восстановление квантованной позиции (задается Mesh::draw)
+layout(location=3) in vec3 aPosScale;
+layout(location=4) in vec3 aPosOffset;
+#ifdef USE_INSTANCING
+// Параметры экземпляра (InstanceStream) вместо uModel
+layout(location=5) in mat4 aInstanceModel;
+layout(location=9) in vec3 aInstanceTint;
+#endif
 
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProj;
 uniform vec2 uUVMul;
 uniform vec2 uUVOffset;
 
@@ -33,15 +66,24 @@ out vec3 vNrm;
 out vec2 vUV;
 out vec3 vObjPos;
 out vec3 vObjNrm;
+out vec3 vTint;
 
 void main() {
-    vec4 wpos = uModel * vec4(aPos, 1.0);
+#ifdef USE_INSTANCING
+    mat4 model = aInstanceModel;
+    vTint = aInstanceTint;
+#else
+    mat4 model = uModel;
+    vTint = vec3(1.0);
+#endif
+    vec3 pos = aPos * aPosScale + aPosOffset;
+    vec4 wpos = model * vec4(pos, 1.0);
     vPos = wpos.xyz;
-    vNrm = mat3(uModel) * aNrm;
+    vNrm = mat3(model) * aNrm;
     vUV = aUV * uUVMul + uUVOffset;
     // Значения в объектном пространстве используются для box-mapped UV
     // (это предотвращает плавание текстуры при вращении).
-    vObjPos = aPos;
+    vObjPos = pos;
     vObjNrm = aNrm;
     gl_Position = uProj * uView * wpos;
 }
@@ -75,54 +117,53 @@ Scene::~Scene()
     delete m_outBoat;   m_outBoat = nullptr;
 }
 
+// Варианты программы (LitFeature в uniforms.h):
+//   USE_TEXTURE      - альбедо из текстуры uTex;
+//   USE_BOX_MAP      - UV из позиции в пространстве объекта по доминирующей оси нормали;
+//   USE_SPECULAR_MAP - интенсивность блика из карты uMapKs (канал R);
+//   USE_INSTANCING   - матрица модели и цветовой множитель из атрибутов экземпляра
 static const char* FS_LIT = R"GLSL(
-#version 330 core
 in vec3 vPos;
 in vec3 vNrm;
 in vec2 vUV;
 in vec3 vObjPos;
 in vec3 vObjNrm;
+in vec3 vTint;
 
+#ifdef USE_TEXTURE
 uniform sampler2D uTex;
-uniform vec3 uCamPos;
-
-uniform vec3 uSunDir;
-uniform vec3 uSunColor;
-uniform float uAmbient;
+#endif
+#ifdef USE_SPECULAR_MAP
+uniform sampler2D uMapKs;
+#endif
 uniform vec3 uTint;
 
 uniform float uSpecularStrength;
 uniform float uSpecularPower;
-uniform int uUseTexture;
-// Опциональная box-развертка для текстур.
-// Если включено, UV генерируются из мировой позиции по доминирующей оси нормали.
-uniform int  uUseBoxMap; // 0 = использовать vUV, 1 = box-map из OBJECT-space pos/nrm
+#ifdef USE_BOX_MAP
 uniform vec3 uBoxScale;  // Тайлинг (повторов на единицу объекта) для X, Y, Z
+#endif
 
 out vec4 FragColor;
 
 void main() {
-    vec3 texColor = vec3(1.0);
-    if (uUseTexture != 0) {
-        vec2 uv = vUV;
-        if (uUseBoxMap != 0) {
-            // Box mapping: выбираем плоскость проекции по доминирующей оси нормали
-            // Используется объектное пространство, чтобы развертка приклеивалась к геометрии при вращении.
-            vec3 an = abs(normalize(vObjNrm));
-            if (an.y >= an.x && an.y >= an.z) {
-                // Верх/низ -> XZ
-                uv = vObjPos.xz * vec2(uBoxScale.x, uBoxScale.z);
-            } else if (an.x >= an.y && an.x >= an.z){
-                // +/-X -> ZY
-                uv = vObjPos.zy * vec2(uBoxScale.z, uBoxScale.y);
-            } else {
-                // +/-Z -> XY
-                uv = vObjPos.xy * vec2(uBoxScale.x, uBoxScale.y);
-            }
-        }
-        texColor = texture(uTex, uv).rgb;
-    }
-    vec3 albedo = texColor * uTint;
+    vec2 uv = vUV;
+#ifdef USE_BOX_MAP
+    // Box mapping: плоскость проекции выбирается по доминирующей оси нормали
+    // (верх/низ -> XZ, +/-X -> ZY, +/-Z -> XY) без ветвлений.
+    // Используется объектное пространство, чтобы развертка приклеивалась к геометрии при вращении.
+    vec3 an = abs(normalize(vObjNrm));
+    float useY = step(max(an.x, an.z), an.y);
+    float useX = (1.0 - useY) * step(an.z, an.x);
+    uv = mix(mix(vObjPos.xy * uBoxScale.xy, vObjPos.zy * uBoxScale.zy, useX),
+             vObjPos.xz * uBoxScale.xz, useY);
+#endif
+
+#ifdef USE_TEXTURE
+    vec3 albedo = texture(uTex, uv).rgb * uTint * vTint;
+#else
+    vec3 albedo = uTint * vTint;
+#endif
 
     vec3 N = normalize(vNrm);
     vec3 L = normalize(-uSunDir);
@@ -135,6 +176,9 @@ void main() {
     vec3 V = normalize(uCamPos - vPos);
     vec3 H = normalize(L + V);
     float spec = pow(max(dot(N, H), 0.0), max(uSpecularPower, 1.0)) * uSpecularStrength;
+#ifdef USE_SPECULAR_MAP
+    spec *= texture(uMapKs, uv).r;
+#endif
 
     vec3 col = amb + diff + spec*uSunColor;
     FragColor = vec4(col, 1.0);
@@ -142,14 +186,12 @@ void main() {
 )GLSL";
 
 static const char* VS_WATER = R"GLSL(
-#version 330 core
 layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aNrm;
 layout(location=2) in vec2 aUV;
+layout(location=3) in vec3 aPosScale;
+layout(location=4) in vec3 aPosOffset;
 
-uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProj;
 uniform vec2 uUVOffset;
 
 out vec2 vUV;
@@ -158,20 +200,15 @@ out vec3 vNrm;
 void main() {
     vUV = aUV + uUVOffset;
     vNrm = mat3(uModel) * aNrm;
-    gl_Position = uProj * uView * (uModel * vec4(aPos, 1.0));
+    gl_Position = uProj * uView * (uModel * vec4(aPos * aPosScale + aPosOffset, 1.0));
 }
 )GLSL";
 
 static const char* FS_WATER = R"GLSL(
-#version 330 core
 in vec2 vUV;
 in vec3 vNrm;
 
 uniform sampler2D uTex;
-uniform vec3 uSunDir;
-uniform vec3 uSunColor;
-uniform float uAmbient;
-uniform float uNight;
 
 out vec4 FragColor;
 
@@ -192,6 +229,13 @@ void main() {
 }
 )GLSL";
 
+void Scene::setModel(QOpenGLFunctions_3_3_Core* f, const Mat4& model) const
+{
+    ObjectUniforms block;
+    std::copy(model.m.begin(), model.m.end(), block.model);
+    objectUniforms.push(f, ObjectBlockBinding, block);
+}
+
 float Scene::dayNightFactor() const
 {
     return nightBlend;
@@ -200,21 +244,58 @@ float Scene::dayNightFactor() const
 void Scene::init(QOpenGLFunctions_3_3_Core* f)
 {
     QString log;
-    shaderLit.build(f, VS_LIT, FS_LIT, &log);
-    shaderWater.build(f, VS_WATER, FS_WATER, &log);
-
-    // Загрузка текстур
-    texRoad.load(f, ":/textures/road.png", true);
-    texWater.load(f, ":/textures/water.png", false);
-    texStone.load(f, ":/textures/stone.png", true);
-    texBrick.load(f, ":/textures/brick.png", true);
-    texSteel.load(f, ":/textures/steel.png", true);
-    texRock.load(f, ":/textures/rock.png", true);
-    texBank.load(f, ":/textures/brick.png", true);
+    auto source = [](std::initializer_list<const char*> parts){
+        std::string src = GLSL_VERSION;
+        for (const char* p : parts) src += p;
+        return src;
+    };
+    const std::string vsLit = source({GLSL_FRAME_UNIFORMS, GLSL_OBJECT_UNIFORMS, VS_LIT});
+    const std::string fsLit = source({GLSL_FRAME_UNIFORMS, FS_LIT});
+    const std::string vsWater = source({GLSL_FRAME_UNIFORMS, GLSL_OBJECT_UNIFORMS, VS_WATER});
+    const std::string fsWater = source({GLSL_FRAME_UNIFORMS, FS_WATER});
+    shaderWater.build(f, vsWater.c_str(), fsWater.c_str(), &log);
+
+    // Общие uniform-блоки: кадр - один буфер для всех программ, объекты - кольцевой буфер
+    shaderWater.bindUniformBlock(f, "FrameUniforms", FrameBlockBinding);
+    shaderWater.bindUniformBlock(f, "ObjectUniforms", ObjectBlockBinding);
+
+    // Варианты освещения: частые собираются заранее, остальные - при первом обращении
+    shaderLit.setSource(vsLit, fsLit, {"USE_TEXTURE", "USE_BOX_MAP", "USE_SPECULAR_MAP", "USE_INSTANCING"});
+    shaderLit.bindUniformBlock("FrameUniforms", FrameBlockBinding);
+    shaderLit.bindUniformBlock("ObjectUniforms", ObjectBlockBinding);
+    for (unsigned mask : {0u, unsigned(LitTexture), unsigned(LitTexture | LitBoxMap),
+                          unsigned(LitInstanced), unsigned(LitInstanced | LitTexture)}){
+        shaderLit.build(f, mask, &log);
+    }
+    shaderLit.setInt(f, Uniform::MapKs, 1);
+    frameUniforms.init(f, sizeof(FrameUniforms), FrameBlockBinding);
+    objectUniforms.init(f, kObjectUniformRingBytes);
+    instances.init(f, kInstanceStreamBytes);
+
+    // Загрузка текстур: чтение и декодирование в пуле потоков, выгрузка в AssetLoader::pump.
+    // До выгрузки вместо текстуры привязывается пустая (0).
+    // Одинаковые файлы (кирпич опор и берега) загружаются в GPU один раз
+    auto texture = [&](TextureHandle& slot, const char* path, bool srgb){
+        slot = std::make_shared<const Texture>();
+        TextureDesc desc;
+        desc.path = path;
+        desc.srgb = srgb;
+        TextureRegistry::instance().acquireAsync(desc, [&slot](TextureHandle t){
+            if (t) slot = std::move(t);
+        });
+    };
+    texture(texRoad,  ":/textures/road.png", true);
+    texture(texWater, ":/textures/water.png", false);
+    texture(texStone, ":/textures/stone.png", true);
+    texture(texBrick, ":/textures/brick.png", true);
+    texture(texSteel, ":/textures/steel.png", true);
+    texture(texRock,  ":/textures/rock.png", true);
+    texture(texBank,  ":/textures/brick.png", true);
 
     // Создание объектов
     auto br = std::make_unique<Bridge>();
     bridge = br.get();
+    bridge->buildGeometry(f);
     objects.push_back(std::move(br));
 
     // Транспорт (4 полосы: 2 в каждом направлении)
@@ -292,6 +373,8 @@ void Scene::init(QOpenGLFunctions_3_3_Core* f)
         objects.push_back(std::move(boat));
     }
 
+    updateObjectTree();
+
     // Звук (Qt Multimedia)
     auto mkPlayer = [&](QMediaPlayer*& pl, QAudioOutput*& out, const QUrl& url, float volume, bool loop){
         if (pl) return; // Уже создано
@@ -324,67 +407,89 @@ void Scene::triggerNight()
 
 static void enforceVehicleSpacing(Scene& scene)
 {
-    std::vector<Vehicle*> vehicles;
-    vehicles.reserve(scene.objects.size());
-    for (auto& o : scene.objects){
-        if (auto* v = dynamic_cast<Vehicle*>(o.get())){
-            if (v->isActive()) vehicles.push_back(v);
-        }
+    // Активный транспорт от головы потока к хвосту: к моменту обработки машины
+    // все, кто едет перед ней, уже стоят на окончательных местах
+    std::vector<int> order;
+    float maxLength = 0.0f;
+    for (size_t k = 0; k < scene.objects.size(); ++k){
+        auto* v = dynamic_cast<Vehicle*>(scene.objects[k].get());
+        if (!v || !v->isActive() || scene.objectProxies[k] == AabbTree::kNull) continue;
+        order.push_back(int(k));
+        maxLength = std::max(maxLength, v->approxLength());
     }
+    auto vehicle = [&](int k){ return static_cast<Vehicle*>(scene.objects[k].get()); };
+    auto progress = [&](int k){ return vehicle(k)->position.x * ((vehicle(k)->direction > 0.0f) ? 1.0f : -1.0f); };
+    std::sort(order.begin(), order.end(), [&](int a, int b){ return progress(a) > progress(b); });
 
-    struct Key { float laneZ; int dir; };
-    auto sameLane = [](float a, float b){ return std::fabs(a - b) < 0.001f; };
+    std::vector<int> rank(scene.objects.size(), -1);
+    for (size_t r = 0; r < order.size(); ++r) rank[order[r]] = int(r);
 
-    std::vector<Key> keys;
-    for (auto* v : vehicles){
-        Key k{v->laneZ, (v->direction > 0.0f) ? 1 : -1};
-        bool exists = false;
-        for (auto& kk : keys){
-            if (kk.dir == k.dir && sameLane(kk.laneZ, k.laneZ)) { exists = true; break; }
+    auto sameLane = [](float a, float b){ return std::fabs(a - b) < 0.001f; };
+    const float buffer = 0.8f; // Небольшой запас
+
+    for (int k : order){
+        Vehicle* back = vehicle(k);
+        const float dir = (back->direction > 0.0f) ? 1.0f : -1.0f;
+        const Vec3 p = back->position;
+
+        // Ближайший сосед впереди в той же полосе - из дерева, на отрезке полосы длиной
+        // не меньше любой допустимой дистанции
+        const float reach = std::max(scene.minVehicleGap, 0.5f * (back->approxLength() + maxLength) + buffer);
+        const Vec3 qMin{(dir > 0.0f) ? p.x : p.x - reach, p.y, back->laneZ};
+        const Vec3 qMax{(dir > 0.0f) ? p.x + reach : p.x, p.y, back->laneZ};
+
+        Vehicle* front = nullptr;
+        float frontAhead = 0.0f;
+        scene.objectTree.query(qMin, qMax, [&](int proxy){
+            const int j = scene.objectTree.userData(proxy);
+            if (rank[j] < 0 || rank[j] >= rank[k]) return true;
+            Vehicle* v = vehicle(j);
+            if (((v->direction > 0.0f) ? 1.0f : -1.0f) != dir || !sameLane(v->laneZ, back->laneZ)) return true;
+            const float ahead = (v->position.x - p.x) * dir;
+            if (!front || ahead < frontAhead){
+                front = v;
+                frontAhead = ahead;
+            }
+            return true;
+        });
+        if (!front) continue;
+
+        // Дистанция рассчитывается по приблизительным длинам (автобусу нужно больше места)
+        // Позиции считаются центрами моделей по оси X
+        float minCenterGap = 0.5f * (front->approxLength() + back->approxLength()) + buffer;
+        minCenterGap = std::max(minCenterGap, scene.minVehicleGap);
+
+        if (frontAhead < minCenterGap){
+            back->position.x = front->position.x - dir * minCenterGap;
+            scene.updateObjectBounds(k);
         }
-        if (!exists) keys.push_back(k);
     }
+}
 
-    for (auto& k : keys){
-        std::vector<Vehicle*> lane;
-        for (auto* v : vehicles){
-            if (((v->direction > 0.0f) ? 1 : -1) == k.dir && sameLane(v->laneZ, k.laneZ)) lane.push_back(v);
-        }
-
-        if (lane.size() < 2) continue;
-
-        if (k.dir > 0){
-            std::sort(lane.begin(), lane.end(), [](Vehicle* a, Vehicle* b){ return a->position.x > b->position.x; });
-            for (size_t idx = 1; idx < lane.size(); ++idx){
-                Vehicle* front = lane[idx-1];
-                Vehicle* back  = lane[idx];
-
-                // Дистанция рассчитывается по приблизительным длинам (автобусу нужно больше места)
-                // Позиции считаются центрами моделей по оси X
-                const float buffer = 0.8f; // Небольшой запас
-                float minCenterGap = 0.5f * (front->approxLength() + back->approxLength()) + buffer;
-                minCenterGap = std::max(minCenterGap, scene.minVehicleGap);
-
-                float maxX = front->position.x - minCenterGap;
-                if (back->position.x > maxX) back->position.x = maxX;
-            }
-        } else {
-            std::sort(lane.begin(), lane.end(), [](Vehicle* a, Vehicle* b){ return a->position.x < b->position.x; });
-            for (size_t idx = 1; idx < lane.size(); ++idx){
-                Vehicle* front = lane[idx-1];
-                Vehicle* back  = lane[idx];
-
-                const float buffer = 0.8f;
-                float minCenterGap = 0.5f * (front->approxLength() + back->approxLength()) + buffer;
-                minCenterGap = std::max(minCenterGap, scene.minVehicleGap);
-
-                float minX = front->position.x + minCenterGap;
-                if (back->position.x < minX) back->position.x = minX;
-            }
-        }
+void Scene::updateObjectBounds(int index)
+{
+    const Bounds b = objects[index]->worldBounds();
+    objectBounds[index] = b;
+
+    int& proxy = objectProxies[index];
+    if (b.isEmpty()){
+        if (proxy != AabbTree::kNull) objectTree.remove(proxy);
+        proxy = AabbTree::kNull;
+    } else if (proxy == AabbTree::kNull){
+        proxy = objectTree.insert(b, index);
+    } else {
+        objectTree.update(proxy, b);
     }
 }
 
+void Scene::updateObjectTree()
+{
+    // Листья переставляются, только когда объект выходит за расширенные границы
+    objectProxies.resize(objects.size(), AabbTree::kNull);
+    objectBounds.resize(objects.size());
+    for (size_t k = 0; k < objects.size(); ++k) updateObjectBounds(int(k));
+}
+
 void Scene::update(float dt)
 {
     time += dt;
@@ -607,142 +712,138 @@ void Scene::update(float dt)
         }
     }
 
-    // Контроль дистанции трафика
+    // Границы объектов после движения; по ним же ищутся соседи для контроля дистанции
+    updateObjectTree();
     enforceVehicleSpacing(*this);
 }
 
 void Scene::draw(QOpenGLFunctions_3_3_Core* f, int w, int h)
 {
+    // Между кадрами состояние GL меняет Qt (композиция виджета)
+    GLState::instance().invalidate();
+
+    // Выгрузка в GPU ресурсов, подготовленных в фоне (в пределах бюджета кадра)
+    AssetLoader::instance().pump(f, kUploadBudgetMs);
+    // Сначала модели: их части держат дескрипторы текстур, освобождаемых в collect
+    ModelCache::instance().purge(f);
+    TextureRegistry::instance().collect(f);
+
     float aspect = (h == 0) ? 1.0f : float(w)/float(h);
+    viewportHeight = std::max(1, h);
     Mat4 V = cam.view();
     Mat4 P = cam.proj(aspect);
     Vec3 camPos = cam.eye();
 
-    // Отрисовка всех объектов
-    for (auto& o : objects){
-        // Мост рисуется отдельно (дорожное полотно и вода - разными шейдерами)
-        (void)o;
+    // Параметры кадра загружаются один раз для всех программ
+    FrameUniforms frame;
+    std::copy(V.m.begin(), V.m.end(), frame.view);
+    std::copy(P.m.begin(), P.m.end(), frame.proj);
+    frame.camPos[0] = camPos.x; frame.camPos[1] = camPos.y; frame.camPos[2] = camPos.z;
+    frame.ambient = light.ambient;
+    frame.sunDir[0] = light.sunDir.x; frame.sunDir[1] = light.sunDir.y; frame.sunDir[2] = light.sunDir.z;
+    frame.night = dayNightFactor();
+    frame.sunColor[0] = light.sunColor.x; frame.sunColor[1] = light.sunColor.y; frame.sunColor[2] = light.sunColor.z;
+    frame.pad = 0.0f;
+    frameUniforms.update(f, &frame, sizeof(frame));
+
+    // Непрозрачные объекты: пакеты всех объектов сортируются очередью
+    // по программе, текстурам и материалу, внутри группы - от ближних к дальним
+    // Объекты вне пирамиды видимости пакетов не добавляют
+    frustum.setMatrix(P * V);
+    objectVisible.assign(objects.size(), 0);
+    for (size_t k = 0; k < objects.size(); ++k){
+        if (k >= objectProxies.size() || objectProxies[k] == AabbTree::kNull) objectVisible[k] = 1;
     }
-
-    // Рисование в два прохода: сначала непрозрачные объекты (мост, транспорт, лодка),
-    // затем вода (все еще непрозрачная, но с отдельным шейдером)
-    shaderLit.use(f);
-    // Управление UV по умолчанию для шейдера освещения
-    {
-        int locMul = f->glGetUniformLocation(shaderLit.id(), "uUVMul");
-        int locOff = f->glGetUniformLocation(shaderLit.id(), "uUVOffset");
-        if (locMul >= 0) f->glUniform2f(locMul, 1.0f, 1.0f);
-        if (locOff >= 0) f->glUniform2f(locOff, 0.0f, 0.0f);
-    }
-    shaderLit.setMat4(f, "uView", V.data());
-    shaderLit.setMat4(f, "uProj", P.data());
-    shaderLit.setVec3(f, "uCamPos", camPos.x, camPos.y, camPos.z);
-    shaderLit.setVec3(f, "uSunDir", light.sunDir.x, light.sunDir.y, light.sunDir.z);
-    shaderLit.setVec3(f, "uSunColor", light.sunColor.x, light.sunColor.y, light.sunColor.z);
-    shaderLit.setFloat(f, "uAmbient", light.ambient);
-    shaderLit.setFloat(f, "uSpecularStrength", 0.25f);
-    shaderLit.setFloat(f, "uSpecularPower", 32.0f);
-    shaderLit.setVec3(f, "uTint", 1.0f, 1.0f, 1.0f);
-    shaderLit.setInt(f, "uUseTexture", 1);
-    // По умолчанию используется UV из меша
-    shaderLit.setInt(f, "uUseBoxMap", 0);
-    shaderLit.setVec3(f, "uBoxScale", 1.0f, 1.0f, 1.0f);
-    shaderLit.setInt(f, "uTex", 0);
-
-    // Непрозрачные объекты, кроме воды (мост сам отдельно вызовет drawOpaque)
-    for (auto& o : objects){
-        if (auto br = dynamic_cast<Bridge*>(o.get())){
-            br->drawOpaque(f, shaderLit, texRoad, texStone, texBrick, texSteel, texRock, texBank);
+    cullBounds.clear();
+    cullCandidates.clear();
+    objectTree.query(frustum, [&](int proxy, bool inside){
+        const int k = objectTree.userData(proxy);
+        if (inside){
+            objectVisible[k] = 1;
         } else {
-            o->draw(f, shaderLit);
+            cullCandidates.push_back(k);
+            cullBounds.add(objectBounds[k]);
         }
+    });
+    frustum.cull(cullBounds, cullVisible);
+    for (size_t c = 0; c < cullCandidates.size(); ++c){
+        if (cullVisible[c]) objectVisible[cullCandidates[c]] = 1;
     }
 
-    // Проход для воды
-    shaderWater.use(f);
-    shaderWater.setMat4(f, "uView", V.data());
-    shaderWater.setMat4(f, "uProj", P.data());
-    shaderWater.setVec3(f, "uSunDir", light.sunDir.x, light.sunDir.y, light.sunDir.z);
-    shaderWater.setVec3(f, "uSunColor", light.sunColor.x, light.sunColor.y, light.sunColor.z);
-    shaderWater.setFloat(f, "uAmbient", light.ambient);
-    shaderWater.setFloat(f, "uNight", dayNightFactor());
-    shaderWater.setInt(f, "uTex", 0);
-
-    for (auto& o : objects){
-        if (auto br = dynamic_cast<Bridge*>(o.get())){
-            br->drawWater(f, shaderWater, texWater, waterUVOffset);
-        }
+    renderQueue.begin(camPos);
+    visibleObjects = 0;
+    for (size_t k = 0; k < objects.size(); ++k){
+        if (!objectVisible[k]) continue;
+        objects[k]->submit(renderQueue, *this);
+        ++visibleObjects;
+    }
+    shaderLit.setVec2(f, Uniform::UVOffset, 0.0f, 0.0f);
+    renderQueue.flush(f, shaderLit, *this);
+
+    // Проход для воды (все еще непрозрачной, но с отдельным шейдером)
+    if (bridge){
+        shaderWater.use(f);
+        shaderWater.setInt(f, Uniform::Tex, 0);
+        bridge->drawWater(f, shaderWater, *this, *texWater, waterUVOffset);
     }
 }
 
-static std::array<float,4> mulMat4Vec4(const Mat4& m, float x, float y, float z, float w)
+void Scene::pickRay(int x, int y, int viewportW, int viewportH, Vec3& origin, Vec3& dir) const
 {
-    const auto& a = m.m;
-    return {
-        a[0]*x + a[4]*y + a[8]*z  + a[12]*w,
-        a[1]*x + a[5]*y + a[9]*z  + a[13]*w,
-        a[2]*x + a[6]*y + a[10]*z + a[14]*w,
-        a[3]*x + a[7]*y + a[11]*z + a[15]*w
+    const float aspect = float(viewportW) / float(viewportH);
+    const Mat4 invVP = inverse(cam.proj(aspect) * cam.view());
+
+    // Точки пикселя на ближней и дальней плоскостях отсечения
+    const float ndcX = (float(x) + 0.5f) / float(viewportW) * 2.0f - 1.0f;
+    const float ndcY = 1.0f - (float(y) + 0.5f) / float(viewportH) * 2.0f;
+    auto unproject = [&](float ndcZ){
+        const auto& a = invVP.m;
+        const float w = a[3]*ndcX + a[7]*ndcY + a[11]*ndcZ + a[15];
+        return transformPoint(invVP, {ndcX, ndcY, ndcZ}) * (1.0f / w);
     };
+    origin = unproject(-1.0f);
+    dir = normalize(unproject(1.0f) - origin);
 }
 
-void Scene::handleClick(int x, int y, int viewportW, int viewportH)
+bool Scene::pick(int x, int y, int viewportW, int viewportH, PickResult& result) const
 {
-    if (viewportW <= 0 || viewportH <= 0) return;
-
-    const float aspect = float(viewportW) / float(viewportH);
-    const Mat4 V = cam.view();
-    const Mat4 P = cam.proj(aspect);
-    const Mat4 VP = P * V;
-
-    Vehicle* best = nullptr;
-    float bestDist2 = 1e30f;
-
-    for (auto& obj : objects)
-    {
-        auto* v = dynamic_cast<Vehicle*>(obj.get());
-        if (!v) continue;
-
-        const Vec3 wp = v->position;
-        auto clip = mulMat4Vec4(VP, wp.x, wp.y, wp.z, 1.0f);
-        if (clip[3] <= 0.0001f) continue; // За камерой
-
-        const float invW = 1.0f / clip[3];
-        const float ndcX = clip[0] * invW;
-        const float ndcY = clip[1] * invW;
-
-        // За пределами видимой области
-        if (ndcX < -1.2f || ndcX > 1.2f || ndcY < -1.2f || ndcY > 1.2f) continue;
-
-        const float sx = (ndcX * 0.5f + 0.5f) * float(viewportW);
-        const float sy = (1.0f - (ndcY * 0.5f + 0.5f)) * float(viewportH);
-
-        // Радиус выбора в мировых единицах (грубая оценка по длине транспорта)
-        const float rW = std::max(0.35f, 0.55f * v->approxLength());
-        auto clipR = mulMat4Vec4(VP, wp.x + rW, wp.y, wp.z, 1.0f);
-        float rPx = 18.0f;
-        if (clipR[3] > 0.0001f){
-            const float invWR = 1.0f / clipR[3];
-            const float ndcXR = clipR[0] * invWR;
-            const float sxR = (ndcXR * 0.5f + 0.5f) * float(viewportW);
-            rPx = std::max(10.0f, std::abs(sxR - sx));
+    result = PickResult();
+    if (viewportW <= 0 || viewportH <= 0) return false;
+
+    Vec3 origin, dir;
+    pickRay(x, y, viewportW, viewportH, origin, dir);
+    const Vec3 invDir = rayInverse(dir);
+
+    // Листья дерева отсекаются по уже найденному ближайшему попаданию
+    float bestT = std::numeric_limits<float>::max();
+    objectTree.raycast(origin, dir, bestT, [&](int proxy, float){
+        const int k = objectTree.userData(proxy);
+        float entry = 0.0f;
+        if (!rayBoxEntry(objectBounds[k].min, objectBounds[k].max, origin, invDir, bestT, entry)) return bestT;
+
+        RayHit hit;
+        if (objects[k]->raycast(origin, dir, bestT, hit)){
+            result.object = objects[k].get();
+            result.hit = hit;
+            bestT = hit.t;
         }
+        return bestT;
+    });
 
-        const float dx = float(x) - sx;
-        const float dy = float(y) - sy;
-        const float d2 = dx*dx + dy*dy;
-
-        if (d2 <= rPx*rPx && d2 < bestDist2){
-            bestDist2 = d2;
-            best = v;
-        }
-    }
+    if (!result.object) return false;
+    result.point = origin + dir * bestT;
+    return true;
+}
 
-    if (!best) return;
+void Scene::handleClick(int x, int y, int viewportW, int viewportH)
+{
+    // Мост и лодка тоже перехватывают луч: транспорт за ними не выбирается
+    PickResult picked;
+    if (!pick(x, y, viewportW, viewportH, picked)) return;
 
     // Определение типа транспорта через dynamic_cast
-    if (dynamic_cast<Car*>(best)) audioOnCarClicked();
-    else if (dynamic_cast<Bus*>(best)) audioOnBusClicked();
+    if (dynamic_cast<Car*>(picked.object)) audioOnCarClicked();
+    else if (dynamic_cast<Bus*>(picked.object)) audioOnBusClicked();
 }
 
 void Scene::audioPlayClickFx(const QString& file)
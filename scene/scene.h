@@ -6,9 +6,16 @@
 
 #include "camera.h"
 #include "object.h"
+#include "renderqueue.h"
+#include "core/aabbtree.h"
+#include "core/frustum.h"
+#include "core/instancestream.h"
 #include "core/math3d.h"
 #include "core/shader.h"
-#include "core/texture.h"
+#include "core/shadervariants.h"
+#include "core/textureregistry.h"
+#include "core/trianglebvh.h"
+#include "core/uniformbuffer.h"
 
 class Bridge;
 class QAudioOutput;
@@ -28,11 +35,17 @@ public:
     Camera cam;
     Lighting light;
 
+    int viewportHeight = 1; // Пиксели, обновляется в draw
+
+    // Размер единицы длины в пикселях на расстоянии distance от камеры (для выбора LOD)
+    float pixelsPerUnit(float distance) const { return cam.pixelsPerUnit(distance, viewportHeight); }
+
     float time = 0.0f; // Время сцены в секундах
 
     float nightBlend = 0.0f;
     float nightBlendTarget = 0.0f;
     static constexpr float kNightBlendDuration = 3.0f; // Секунды
+    static constexpr double kUploadBudgetMs = 2.0;     // Время кадра на выгрузку фоновых ресурсов
 
     bool isNight = false; // Используется для пуска/останова трафика
 
@@ -58,17 +71,49 @@ public:
     void triggerNight();
 
     // Ресурсные файлы
-    Shader shaderLit;
+    ShaderVariants shaderLit; // Варианты по LitFeature
     Shader shaderWater;
 
-    Texture texRoad;
-    Texture texWater;
-
-    Texture texStone;
-    Texture texBrick;
-    Texture texSteel;
-    Texture texRock;
-    Texture texBank;
+    // Uniform-блоки (uniforms.h): параметры кадра и поток параметров объектов
+    UniformBuffer frameUniforms;
+    mutable UniformRing objectUniforms;
+    static constexpr size_t kObjectUniformRingBytes = 256 * 1024;
+
+    // Матрица модели для следующего вызова отрисовки (блок ObjectUniforms)
+    void setModel(QOpenGLFunctions_3_3_Core* f, const Mat4& model) const;
+
+    // Пакеты отрисовки кадра (непрозрачные объекты программы освещения)
+    RenderQueue renderQueue;
+
+    // Динамическое дерево AABB объектов (обновляется в update): отсечение,
+    // выбор мышью и поиск соседей транспорта
+    AabbTree objectTree;
+    std::vector<int> objectProxies;   // Лист каждого объекта; AabbTree::kNull - границ нет, не отсекается
+    std::vector<Bounds> objectBounds; // Точные границы на момент обновления дерева
+    void updateObjectTree();
+    void updateObjectBounds(int index);
+
+    // Отсечение по пирамиде видимости: дерево отбрасывает целые поддеревья,
+    // листья на границе пирамиды проверяются пачкой по точным границам (SIMD)
+    Frustum frustum;
+    PackedBounds cullBounds;
+    std::vector<int> cullCandidates;
+    std::vector<uint8_t> cullVisible;
+    std::vector<uint8_t> objectVisible;
+    int visibleObjects = 0; // Прошедшие отсечение в последнем кадре
+
+    // Параметры экземпляров для инстансинга (80 байт на экземпляр)
+    mutable InstanceStream instances;
+    static constexpr size_t kInstanceStreamBytes = 2 * 1024 * 1024;
+
+    TextureHandle texRoad;
+    TextureHandle texWater;
+
+    TextureHandle texStone;
+    TextureHandle texBrick;
+    TextureHandle texSteel;
+    TextureHandle texRock;
+    TextureHandle texBank;
 
     // Аудио
     QMediaPlayer* m_playerRoad   = nullptr;
@@ -98,6 +143,18 @@ public:
     void init(QOpenGLFunctions_3_3_Core* f);
     void update(float dt);
     void handleClick(int x, int y, int viewportW, int viewportH);
+    // Луч через пиксель (x, y) окна: обратное преобразование proj * view
+    void pickRay(int x, int y, int viewportW, int viewportH, Vec3& origin, Vec3& dir) const;
+
+    // Выбор лучом: ближайший объект, его часть и треугольник (дерево объектов,
+    // точные границы, затем BVH треугольников модели)
+    struct PickResult
+    {
+        Object* object = nullptr;
+        RayHit hit;
+        Vec3 point{0, 0, 0}; // Точка попадания (мировые координаты)
+    };
+    bool pick(int x, int y, int viewportW, int viewportH, PickResult& result) const;
     void draw(QOpenGLFunctions_3_3_Core* f, int w, int h);
 
     // Вспомогательные методы
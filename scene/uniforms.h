@@ -0,0 +1,56 @@
+#ifndef UNIFORMS_H
+#define UNIFORMS_H
+
+#include "core/shader.h"
+
+// Uniform-блоки шейдеров сцены (раскладка std140, объявления GLSL - в scene.cpp)
+enum UniformBlockBinding
+{
+    FrameBlockBinding = 0,  // FrameUniforms: один раз за кадр, общий для всех программ
+    ObjectBlockBinding = 1  // ObjectUniforms: на каждый вызов отрисовки (UniformRing)
+};
+
+struct FrameUniforms
+{
+    float view[16];
+    float proj[16];
+    float camPos[3];
+    float ambient;
+    float sunDir[3];
+    float night;
+    float sunColor[3];
+    float pad;
+};
+static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 block");
+
+struct ObjectUniforms
+{
+    float model[16];
+};
+static_assert(sizeof(ObjectUniforms) == 64, "ObjectUniforms must match the std140 block");
+
+// Возможности вариантов программы освещения (Scene::shaderLit, биты маски ShaderVariants)
+enum LitFeature : unsigned
+{
+    LitTexture     = 1u << 0, // USE_TEXTURE
+    LitBoxMap      = 1u << 1, // USE_BOX_MAP
+    LitSpecularMap = 1u << 2, // USE_SPECULAR_MAP
+    LitInstanced   = 1u << 3  // USE_INSTANCING
+};
+
+// Uniform-переменные вне блоков (исходники шейдеров - в scene.cpp)
+namespace Uniform
+{
+    constexpr UniformId UVMul("uUVMul");
+    constexpr UniformId UVOffset("uUVOffset");
+
+    // Материал
+    constexpr UniformId Tex("uTex");
+    constexpr UniformId Tint("uTint");
+    constexpr UniformId SpecularStrength("uSpecularStrength");
+    constexpr UniformId SpecularPower("uSpecularPower");
+    constexpr UniformId BoxScale("uBoxScale");
+    constexpr UniformId MapKs("uMapKs");
+}
+
+#endif // UNIFORMS_H
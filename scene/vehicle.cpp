@@ -3,60 +3,9 @@
 #include <algorithm>
 #include <memory>
 
-#include <QOpenGLFunctions_3_3_Core>
-#include <QFileInfo>
-#include <QDir>
-
+#include "renderqueue.h"
 #include "scene.h"
-#include "core/shader.h"
-#include "core/objloader.h"
-
-static void normalizeVertices(std::vector<Vertex>& v, float targetMaxDim)
-{
-    if (v.empty()) return;
-
-    Vec3 mn = v[0].pos, mx = v[0].pos;
-    for (const auto& vx : v){
-        mn.x = std::min(mn.x, vx.pos.x); mn.y = std::min(mn.y, vx.pos.y); mn.z = std::min(mn.z, vx.pos.z);
-        mx.x = std::max(mx.x, vx.pos.x); mx.y = std::max(mx.y, vx.pos.y); mx.z = std::max(mx.z, vx.pos.z);
-    }
-    Vec3 size = {mx.x-mn.x, mx.y-mn.y, mx.z-mn.z};
-    float maxDim = std::max(size.x, std::max(size.y, size.z));
-    if (maxDim < 1e-6f) return;
-
-    // Центрирование по XZ и установка на мост по minY = 0
-    Vec3 center = {(mn.x+mx.x)*0.5f, mn.y, (mn.z+mx.z)*0.5f};
-
-    float s = targetMaxDim / maxDim;
-    for (auto& vx : v){
-        vx.pos = (vx.pos - center) * s;
-    }
-}
-
-static void rotateXNeg90(std::vector<Vertex>& v)
-{
-    // Поворот позиций и нормалей вокруг оси X на -90 градусов
-    for (auto& vx : v){
-        float y = vx.pos.y, z = vx.pos.z;
-        vx.pos.y = z;
-        vx.pos.z = -y;
-
-        float ny = vx.nrm.y, nz = vx.nrm.z;
-        vx.nrm.y = nz;
-        vx.nrm.z = -ny;
-    }
-}
-
-static void rotateY180(std::vector<Vertex>& v)
-{
-    // Поворот на 180 градусов вокруг оси Y (разворот модели)
-    for (auto& vert : v){
-        vert.pos.x = -vert.pos.x;
-        vert.pos.z = -vert.pos.z;
-        vert.nrm.x = -vert.nrm.x;
-        vert.nrm.z = -vert.nrm.z;
-    }
-}
+#include "uniforms.h"
 
 Vehicle::Vehicle(const QString& objPath)
     : m_objPath(objPath)
@@ -64,44 +13,19 @@ Vehicle::Vehicle(const QString& objPath)
     position.y = 2.05f;
 }
 
-void Vehicle::ensureUploaded(QOpenGLFunctions_3_3_Core* f) const
+void Vehicle::ensureUploaded() const
 {
-    if (m_uploaded) return;
-
-    std::vector<ObjLoader::ObjPart> parts;
-    if (!ObjLoader::loadParts(m_objPath, parts)) {
-        std::vector<Vertex> v;
-        std::vector<unsigned> ind;
-        ObjLoader::load(":/models/cube.obj", v, ind);
-
-        parts.clear();
-        ObjLoader::ObjPart p;
-        p.vertices = std::move(v);
-        p.indices  = std::move(ind);
-        p.material.name = "default";
-        p.material.kd = {1,1,1};
-        parts.push_back(std::move(p));
-    }
-
-    m_parts.clear();
-    m_parts.reserve(parts.size());
-
-    for (auto& part : parts){
-        if (m_rotXNeg90) rotateXNeg90(part.vertices);
-        if (m_rotY180)   rotateY180(part.vertices);
-        normalizeVertices(part.vertices, m_targetSize);
-
-        ModelPart mp;
-        mp.kd = part.material.kd;
-        mp.useTexture = false; // map_Kd не используется
-        mp.mesh.upload(f, part.vertices, part.indices);
-        m_parts.push_back(std::move(mp));
-    }
-
-    m_uploaded = true;
+    if (m_model) return;
+
+    ModelDesc desc;
+    desc.path = m_objPath;
+    desc.targetSize = m_targetSize;
+    desc.rotXNeg90 = m_rotXNeg90;
+    desc.rotY180 = m_rotY180;
+    desc.loadMaps = false; // map_Kd не используется
+    m_model = ModelCache::instance().acquire(desc);
 }
 
-
 void Vehicle::update(Scene& scene, float dt)
 {
     // Если транспорт был деактивирован ночью (чтобы избежать повторного появления),
@@ -167,28 +91,62 @@ void Vehicle::update(Scene& scene, float dt)
     rotation.y = (direction > 0) ? 0.0f : 3.1415926f;
 }
 
-void Vehicle::draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const
+int Vehicle::selectLod(const Scene& scene) const
+{
+    // Уровень детализации по экранному размеру ошибки упрощения
+    const float maxScale = std::max(scale.x, std::max(scale.y, scale.z));
+    return m_model->selectLod(scene.pixelsPerUnit(length(position - scene.cam.eye())) * maxScale);
+}
+
+Bounds Vehicle::worldBounds() const
+{
+    if (!m_active) return Bounds();
+    ensureUploaded();
+    if (m_model->resident) return m_model->bounds.transformed(modelMatrix());
+
+    // До загрузки модели - куб размера нормализации над опорной точкой
+    // (транспорт участвует в поиске соседей с первого кадра)
+    const float h = 0.5f * m_targetSize;
+    Bounds b;
+    b.min = position + Vec3{-h, 0.0f, -h};
+    b.max = position + Vec3{h, m_targetSize, h};
+    b.center = b.boxCenter();
+    b.radius = length(b.extents());
+    return b;
+}
+
+bool Vehicle::raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const
+{
+    if (!m_active || !m_model || !m_model->resident) return false;
+
+    // BVH частей общий для всех экземпляров модели: луч переводится в ее координаты
+    Vec3 o, d;
+    rayToLocal(modelMatrix(), origin, dir, o, d);
+    return m_model->raycast(o, d, maxT, hit);
+}
+
+void Vehicle::submit(RenderQueue& queue, const Scene& scene) const
 {
     if (!m_active) return;
-    const_cast<Vehicle*>(this)->ensureUploaded(f);
-
-    Mat4 M = modelMatrix();
-    sh.setMat4(f, "uModel", M.data());
-
-    for (const auto& p : m_parts){
-        sh.setVec3(f, "uTint",
-                   p.kd.x * m_tint.x,
-                   p.kd.y * m_tint.y,
-                   p.kd.z * m_tint.z);
-        if (p.useTexture && p.diffuse){
-            p.diffuse->bind(f, 0);
-            sh.setInt(f, "uUseTexture", 1);
-        } else {
-            sh.setInt(f, "uUseTexture", 0);
-        }
-        p.mesh.draw(f);
+    ensureUploaded();
+    if (!m_model->resident) return; // Модель еще загружается в фоне
+
+    // Машины с одной моделью рисуются инстансингом (RenderQueue собирает экземпляры):
+    // uTint несет цвет материала части, цвет машины - атрибут экземпляра
+    InstanceData instance;
+    const Mat4 M = modelMatrix();
+    std::copy(M.m.begin(), M.m.end(), instance.model);
+    instance.tint[0] = m_tint.x;
+    instance.tint[1] = m_tint.y;
+    instance.tint[2] = m_tint.z;
+    instance.pad = 0.0f;
+
+    const int lod = selectLod(scene);
+    for (const auto& p : m_model->parts){
+        RenderMaterial material;
+        material.texture = p.mapKd.get();
+        material.tint = p.material.kd;
+        const unsigned variant = LitInstanced | (p.mapKd ? unsigned(LitTexture) : 0u);
+        queue.submitInstance(p.mesh, lod, variant, material, instance, position);
     }
-
-    sh.setVec3(f, "uTint", 1.0f, 1.0f, 1.0f);
-    sh.setInt(f, "uUseTexture", 1);
 }
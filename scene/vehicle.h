@@ -7,12 +7,10 @@
 #include <QString>
 
 #include "object.h"
-#include "core/mesh.h"
-#include "core/texture.h"
+#include "core/modelcache.h"
 
+class RenderQueue;
 class Scene;
-class Shader;
-class QOpenGLFunctions_3_3_Core;
 
 // Базовый класс объектов транспорта
 class Vehicle : public Object
@@ -27,7 +25,9 @@ public:
     float direction = +1.0f; // +1 -> +X, -1 -> -X
 
     void update(Scene& scene, float dt) override;
-    void draw(QOpenGLFunctions_3_3_Core* f, const Shader& sh) const override;
+    void submit(RenderQueue& queue, const Scene& scene) const override;
+    Bounds worldBounds() const override;
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxT, RayHit& hit) const override;
 
     // Цветовой множитель для случайных цветов
     void setTint(const Vec3& t) { m_tint = t; }
@@ -39,13 +39,6 @@ public:
     float approxLength() const { return m_targetSize; }
 
 protected:
-    struct ModelPart {
-        Mesh mesh;
-        Vec3 kd{1,1,1};
-        std::unique_ptr<Texture> diffuse; // nullptr, если текстуры нет (map_Kd отсутствует)
-        bool useTexture = false;
-    };
-
     QString m_objPath;
 
     // Максимальный размер в мировых единицах после нормализации
@@ -58,10 +51,11 @@ protected:
     // машины, покидающие мост деактивируются
     bool m_active = true;
 
-    mutable bool m_uploaded = false;
-    mutable std::vector<ModelPart> m_parts;
+    // Геометрия разделяется всеми экземплярами с одинаковыми параметрами модели
+    mutable ModelHandle m_model;
 
-    void ensureUploaded(QOpenGLFunctions_3_3_Core* f) const;
+    void ensureUploaded() const;
+    int selectLod(const Scene& scene) const;
 };
 
 class Car : public Vehicle